@@ -44,17 +44,31 @@ class Index(object):
 
         self.stub.MSet(index_pb2.MSetRequest(key_values=key_value_dict))
 
+    def delete(self, key):
+        self.stub.Delete(index_pb2.DeleteRequest(key=key))
+
+    def mdelete(self, keys):
+        self.stub.MDelete(index_pb2.MDeleteRequest(keys=keys))
+
     def get(self, key):
         response = self.stub.Get(index_pb2.GetRequest(key=key))
         return json.loads(response.value) if response.value else None
 
-    def get_fuzzy(self, key, max_edit_distance=3, min_exact_prefix=2):
-        response = self.stub.GetFuzzy(index_pb2.GetFuzzyRequest(key=key, max_edit_distance=max_edit_distance, min_exact_prefix=min_exact_prefix))
-        return response.matches
+    def get_fuzzy(self, key, max_edit_distance=3, min_exact_prefix=2, max_results=0, return_response=False):
+        """
+        Fuzzy match the key, returns the matches or, if return_response is set, the full response including the
+        partial flag set by a coordinator.
+        """
+        response = self.stub.GetFuzzy(index_pb2.GetFuzzyRequest(key=key, max_edit_distance=max_edit_distance, min_exact_prefix=min_exact_prefix, max_results=max_results))
+        return response if return_response else response.matches
 
-    def get_near(self, key, min_exact_prefix=2, greedy=False):
-        response = self.stub.GetNear(index_pb2.GetNearRequest(key=key, min_exact_prefix=min_exact_prefix, greedy=greedy))
-        return response.matches
+    def get_near(self, key, min_exact_prefix=2, greedy=False, max_results=0, return_response=False):
+        """
+        Near match the key, returns the matches or, if return_response is set, the full response including the
+        partial flag set by a coordinator.
+        """
+        response = self.stub.GetNear(index_pb2.GetNearRequest(key=key, min_exact_prefix=min_exact_prefix, greedy=greedy, max_results=max_results))
+        return response if return_response else response.matches
 
     def flush(self, asynchronous=False):
         self.stub.Flush(index_pb2.FlushRequest(asynchronous=asynchronous))
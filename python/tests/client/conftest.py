@@ -0,0 +1,75 @@
+# -*- coding: utf-8 -*-
+# Usage: py.test tests
+
+import os
+import pytest
+import random
+import shutil
+import socket
+import subprocess
+import tempfile
+import time
+
+
+KEYVISERVER_BIN = os.path.join(os.path.dirname(os.path.realpath(__file__)), "..", "..", "..", "build", "keyviserver")
+
+
+def wait_for_connection(port):
+    start_time = time.time()
+    while time.time() < start_time + 3:
+        try:
+            sock = socket.socket()
+            sock.connect(('localhost', port))
+            return True
+        except (socket.error, socket.timeout):
+            time.sleep(0.1)
+        finally:
+            # close socket manually for sake of PyPy
+            sock.close()
+    raise Exception("failed to start keyviserver")
+
+
+@pytest.fixture
+def unused_port():
+    """
+    A port nobody listens on.
+    """
+    sock = socket.socket()
+    try:
+        sock.bind(('localhost', 0))
+        return sock.getsockname()[1]
+    finally:
+        sock.close()
+
+
+@pytest.fixture(scope="module")
+def start_keyviserver(request):
+    """
+    Returns a function that starts a keyviserver with the given extra arguments and returns its port.
+
+    Every server gets its own data directory unless one is passed, servers and data directories are removed after
+    the tests of the module.
+    """
+
+    def start(*args):
+        args = list(args)
+        if "-d" not in args and "--shards" not in args:
+            data_dir = tempfile.mkdtemp()
+            request.addfinalizer(lambda: shutil.rmtree(data_dir, ignore_errors=True))
+            args += ["-d", data_dir]
+
+        print("starting from: " + KEYVISERVER_BIN)
+        retry = 0
+        while retry < 10:
+            port = random.randint(10000, 20000)
+            try:
+                proc = subprocess.Popen([KEYVISERVER_BIN, "-p", str(port)] + args, stdout=subprocess.PIPE,
+                                        stderr=subprocess.STDOUT)
+                request.addfinalizer(proc.kill)
+                wait_for_connection(port)
+                return port
+            except:pass
+            retry += 1
+        raise Exception("failed to start keyviserver")
+
+    return start
@@ -0,0 +1,63 @@
+# -*- coding: utf-8 -*-
+# Usage: py.test tests
+
+import pytest
+import keyviserver
+
+
+@pytest.fixture(scope="module")
+def shards(start_keyviserver):
+    ports = [start_keyviserver(), start_keyviserver()]
+
+    shard_0 = keyviserver.client.index.Index(host='localhost', port=ports[0])
+    shard_1 = keyviserver.client.index.Index(host='localhost', port=ports[1])
+    shard_0.mset({"abcd": "1", "abce": "2"})
+    shard_1.mset({"abcf": "3", "abxy": "4"})
+    shard_0.flush()
+    shard_1.flush()
+    return ports
+
+
+def shards_argument(ports):
+    return ",".join("localhost:{}".format(port) for port in ports)
+
+
+def test_fuzzy_and_near(start_keyviserver, shards):
+    c = keyviserver.client.index.Index(host='localhost', port=start_keyviserver("--shards", shards_argument(shards)))
+
+    response = c.get_fuzzy("abcd", max_edit_distance=1, return_response=True)
+    assert not response.partial
+    assert [m.matched_string for m in response.matches] == ["abcd", "abce", "abcf"]
+    assert [m.score for m in response.matches] == [0, 1, 1]
+
+    matches = c.get_fuzzy("abcd", max_edit_distance=1, max_results=2)
+    assert [m.matched_string for m in matches] == ["abcd", "abce"]
+
+    matches = c.get_near("abcx", min_exact_prefix=2)
+    assert [m.matched_string for m in matches] == ["abcd", "abce", "abcf"]
+
+    matches = c.get_near("abcx", min_exact_prefix=2, greedy=True)
+    assert [m.matched_string for m in matches] == ["abcd", "abce", "abcf", "abxy"]
+
+
+def test_partial_results(start_keyviserver, shards, unused_port):
+    # the 2nd shard is not reachable
+    c = keyviserver.client.index.Index(host='localhost',
+                                       port=start_keyviserver("--shards", shards_argument([shards[0], unused_port])))
+
+    response = c.get_fuzzy("abcd", max_edit_distance=1, return_response=True)
+    assert response.partial
+    assert [m.matched_string for m in response.matches] == ["abcd", "abce"]
+
+    response = c.get_near("abcx", min_exact_prefix=2, greedy=True, return_response=True)
+    assert response.partial
+    assert [m.matched_string for m in response.matches] == ["abcd", "abce"]
+
+
+def test_shards_list_with_blanks(start_keyviserver, shards):
+    c = keyviserver.client.index.Index(
+        host='localhost', port=start_keyviserver("--shards", " localhost:{}, localhost:{},".format(*shards)))
+
+    response = c.get_fuzzy("abcd", max_edit_distance=1, return_response=True)
+    assert not response.partial
+    assert [m.matched_string for m in response.matches] == ["abcd", "abce", "abcf"]
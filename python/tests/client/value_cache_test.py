@@ -0,0 +1,21 @@
+# -*- coding: utf-8 -*-
+# Usage: py.test tests
+
+import pytest
+import keyviserver
+
+
+@pytest.fixture(scope="module", autouse=True)
+def keyvi_server(start_keyviserver):
+    return start_keyviserver("--value-cache-mb", "1")
+
+
+def test_overwrite(keyvi_server):
+    c = keyviserver.client.index.Index(host='localhost', port=keyvi_server)
+    c.set("a", "1")
+    c.flush()
+    assert c.get("a") == 1
+    assert c.get("a") == 1
+    c.set("a", "2")
+    c.flush()
+    assert c.get("a") == 2
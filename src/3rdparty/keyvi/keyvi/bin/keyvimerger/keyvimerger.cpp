@@ -25,6 +25,7 @@
 
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/file.hpp>
@@ -32,6 +33,7 @@
 #include <boost/program_options.hpp>
 
 #include "keyvi/dictionary/dictionary_types.h"
+#include "keyvi/dictionary/fsa/automata.h"
 #include "keyvi/util/configuration.h"
 
 /** Extracts the parameters. */
@@ -49,6 +51,17 @@ keyvi::util::parameters_t extract_parameters(const boost::program_options::varia
   return ret;
 }
 
+template <typename MergerT>
+void merge(const keyvi::util::parameters_t& params, const std::vector<std::string>& inputs,
+           const std::string& output_file) {
+  MergerT merger(params);
+  for (auto f : inputs) {
+    merger.Add(f);
+  }
+
+  merger.Merge(output_file);
+}
+
 int main(int argc, char** argv) {
   std::vector<std::string> input_files;
   std::string output_file;
@@ -107,12 +120,28 @@ int main(int argc, char** argv) {
       params[MEMORY_LIMIT_KEY] = vm["memory-limit"].as<std::string>();
     }
 
-    keyvi::dictionary::JsonDictionaryMerger jsonDictionaryMerger(params);
-    for (auto f : inputs) {
-      jsonDictionaryMerger.Add(f);
+    // the inputs must have the same type, which is checked by the merger
+    keyvi::dictionary::dictionary_type_t dictionary_type = keyvi::dictionary::dictionary_type_t::JSON;
+    if (!inputs.empty()) {
+      dictionary_type = keyvi::dictionary::fsa::Automata(inputs.front()).GetValueStoreType();
     }
 
-    jsonDictionaryMerger.Merge(output_file);
+    switch (dictionary_type) {
+      case keyvi::dictionary::dictionary_type_t::STRING:
+        merge<keyvi::dictionary::StringDictionaryMerger>(params, inputs, output_file);
+        break;
+      case keyvi::dictionary::dictionary_type_t::INT:
+        merge<keyvi::dictionary::IntDictionaryMerger>(params, inputs, output_file);
+        break;
+      case keyvi::dictionary::dictionary_type_t::INT_WITH_WEIGHTS:
+        merge<keyvi::dictionary::CompletionDictionaryMerger>(params, inputs, output_file);
+        break;
+      case keyvi::dictionary::dictionary_type_t::KEY_ONLY:
+        merge<keyvi::dictionary::KeyOnlyDictionaryMerger>(params, inputs, output_file);
+        break;
+      default:
+        merge<keyvi::dictionary::JsonDictionaryMerger>(params, inputs, output_file);
+    }
 
   } else {
     std::cout << "ERROR: arguments wrong or missing." << std::endl << std::endl;
@@ -27,19 +27,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
-#ifdef _MSC_VER
-// workaround for https://github.com/boostorg/sort/issues/43
-#include <ciso646>
-#endif
-#include <boost/sort/sort.hpp>
-
 #include "keyvi/dictionary/dictionary_compiler_common.h"
 #include "keyvi/dictionary/fsa/generator_adapter.h"
 #include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/util/key_arena.h"
+#include "keyvi/dictionary/util/key_filter.h"
+#include "keyvi/index/internal/tombstones_file.h"
 #include "keyvi/util/configuration.h"
 #include "keyvi/util/os_utils.h"
 #include "keyvi/util/serialization_utils.h"
@@ -56,7 +54,8 @@ namespace dictionary {
  * specialized compiler to be used in keyvi index. The difference to the normal compiler
  *
  * - handling of order (stable sort)
- * - support for delete
+ * - keys are kept in an arena instead of a string per key
+ * - support for delete, optionally persisted as tombstones to hide the key in older segments
  * - no merge as part of compilation, the index handles this
  */
 template <keyvi::dictionary::fsa::internal::value_store_t ValueStoreType = fsa::internal::value_store_t::KEY_ONLY>
@@ -80,6 +79,9 @@ class DictionaryIndexCompiler final {
 
     parallel_sort_threshold_ =
         keyvi::util::mapGet(params_, PARALLEL_SORT_THRESHOLD_KEY, DEFAULT_PARALLEL_SORT_THRESHOLD);
+    key_filter_bits_per_key_ =
+        keyvi::util::mapGet(params_, KEY_FILTER_BITS_PER_KEY, DEFAULT_KEY_FILTER_BITS_PER_KEY);
+    write_tombstones_ = keyvi::util::mapGetBool(params_, TOMBSTONES_KEY, false);
 
     TRACE("tmp path set to %s", params_[TEMPORARY_PATH_KEY].c_str());
     value_store_ = new ValueStoreT(params_);
@@ -102,10 +104,26 @@ class DictionaryIndexCompiler final {
     }
 
     size_of_keys_ += input_key.size();
+    key_values_.Append(input_key, RegisterValue(value));
+  }
+
+  /**
+   * Add a value that has been encoded upfront with a JsonValueEncoder, only available for the json value store.
+   *
+   * Encoding is the expensive part of adding a json value, this way it can happen on the caller thread.
+   */
+  void AddEncoded(const std::string& input_key, const fsa::internal::EncodedJsonValue& value) {
+    if (generator_) {
+      throw compiler_exception("You're not supposed to add more data once compilation is done!");
+    }
+
+    size_of_keys_ += input_key.size();
+
+    bool no_minimization = false;
+    uint64_t value_idx = value_store_->AddEncodedValue(value, &no_minimization);
 
-    memory_estimate_ += EstimateMemory(input_key);
-    // no move, we have no ownership
-    key_values_.push_back(key_value_t(input_key, RegisterValue(value)));
+    // json values have no weight
+    key_values_.Append(input_key, fsa::ValueHandle(value_idx, 0, no_minimization, false));
   }
 
   void Delete(const std::string& input_key) {
@@ -114,8 +132,7 @@ class DictionaryIndexCompiler final {
                             false,  // minimization
                             true);  // deleted flag
 
-    memory_estimate_ += EstimateMemory(input_key);
-    key_values_.push_back(key_value_t(input_key, handle));
+    key_values_.Append(input_key, handle);
   }
 
   /**
@@ -123,45 +140,32 @@ class DictionaryIndexCompiler final {
    */
   void Compile() {
     value_store_->CloseFeeding();
-    Sort();
+    key_values_.Sort(parallel_sort_threshold_);
 
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
             size_of_keys_, params_, value_store_);
 
+    if (key_filter_bits_per_key_ > 0) {
+      // upper bound, the number of keys after dedup and deletes is not known yet
+      key_filter_.reset(new util::KeyFilter(key_values_.size(), key_filter_bits_per_key_));
+    }
+
     // special mode for stable (incremental) inserts, in this case we have
     // to respect the order and take
     // the last value if keys are equal
-    if (key_values_.size() > 0) {
-      auto key_values_it = key_values_.begin();
-      key_value_t last_key_value = *key_values_it++;
-
-      while (key_values_it != key_values_.end()) {
-        key_value_t key_value = *key_values_it++;
-
-        // dedup with last one wins
-        if (last_key_value.key == key_value.key) {
-          last_key_value = key_value;
-          continue;
-        }
-
-        if (!last_key_value.value.deleted_) {
-          TRACE("adding to generator: %s", last_key_value.key.c_str());
-          generator_->Add(std::move(last_key_value.key), last_key_value.value);
-        } else {
-          TRACE("skipping deleted key: %s", last_key_value.key.c_str());
-        }
-
-        last_key_value = key_value;
+    key_values_.ForEachUnique([this](const std::string& key, const fsa::ValueHandle& value) {
+      if (!value.deleted_) {
+        TRACE("adding to generator: %s", key.c_str());
+        AddToKeyFilter(key);
+        generator_->Add(key, value);
+      } else {
+        TRACE("skipping deleted key: %s", key.c_str());
+        AddTombstone(key);
       }
+    });
+    key_values_.clear();
 
-      // add the last one
-      TRACE("adding to generator: %s", last_key_value.key.c_str());
-      if (!last_key_value.value.deleted_) {
-        generator_->Add(std::move(last_key_value.key), last_key_value.value);
-      }
-      key_values_.clear();
-    }
     generator_->CloseFeeding();
     generator_->SetManifest(manifest_);
   }
@@ -198,25 +202,44 @@ class DictionaryIndexCompiler final {
 
     generator_->Write(out_stream);
     out_stream.close();
+
+    if (key_filter_) {
+      key_filter_->WriteToFile(filename + KEY_FILTER_FILE_SUFFIX);
+    }
+
+    if (!tombstones_.empty()) {
+      index::internal::TombstonesFile::Write(filename, tombstones_);
+    }
   }
 
+  /**
+   * The deletes of the compiled batch, only collected if tombstones are enabled.
+   */
+  const std::vector<std::string>& GetTombstones() const { return tombstones_; }
+
  private:
   keyvi::util::parameters_t params_;
-  std::vector<key_value_t> key_values_;
+  util::KeyArena<fsa::ValueHandle> key_values_;
   ValueStoreT* value_store_;
   typename GeneratorAdapter::AdapterPtr generator_;
   std::string manifest_;
-  size_t memory_estimate_ = 0;
   size_t size_of_keys_ = 0;
   size_t parallel_sort_threshold_;
+  size_t key_filter_bits_per_key_;
+  std::unique_ptr<util::KeyFilter> key_filter_;
+  bool write_tombstones_;
+  std::vector<std::string> tombstones_;
+
+  inline void AddToKeyFilter(const std::string& key) {
+    if (key_filter_) {
+      key_filter_->Add(key);
+    }
+  }
 
-  inline void Sort() {
-    if (key_values_.size() > parallel_sort_threshold_ && parallel_sort_threshold_ != 0) {
-      // see gh#215 parallel_stable_sort segfaults
-      // boost::sort::parallel_stable_sort(key_values_.begin(), key_values_.end());
-      boost::sort::spinsort(key_values_.begin(), key_values_.end());
-    } else {
-      std::stable_sort(key_values_.begin(), key_values_.end());
+  // keys are added in sorted order
+  inline void AddTombstone(const std::string& key) {
+    if (write_tombstones_) {
+      tombstones_.push_back(key);
     }
   }
 
@@ -29,6 +29,7 @@
 #include <cstdint>
 #include <fstream>
 #include <functional>
+#include <map>
 #include <memory>
 #include <queue>
 #include <string>
@@ -45,6 +46,9 @@
 #include "keyvi/dictionary/fsa/internal/constants.h"
 #include "keyvi/dictionary/fsa/internal/value_store_factory.h"
 #include "keyvi/dictionary/fsa/segment_iterator.h"
+#include "keyvi/dictionary/util/key_filter.h"
+#include "keyvi/index/internal/deleted_keys_journal.h"
+#include "keyvi/index/internal/tombstones_file.h"
 #include "keyvi/util/configuration.h"
 
 // #define ENABLE_TRACING
@@ -65,6 +69,8 @@ struct MergeStats {
   size_t number_of_keys_ = 0;
   size_t deleted_keys_ = 0;
   size_t updated_keys_ = 0;
+  // tombstones written to the merged dictionary
+  size_t tombstones_ = 0;
 };
 
 template <keyvi::dictionary::fsa::internal::value_store_t ValueStoreType = fsa::internal::value_store_t::KEY_ONLY>
@@ -86,6 +92,9 @@ class DictionaryMerger final {
     params_[TEMPORARY_PATH_KEY] = keyvi::util::mapGetTemporaryPath(params);
 
     append_merge_ = MERGE_APPEND == keyvi::util::mapGet<std::string>(params_, MERGE_MODE, "");
+    key_filter_bits_per_key_ =
+        keyvi::util::mapGet<size_t>(params_, KEY_FILTER_BITS_PER_KEY, DEFAULT_KEY_FILTER_BITS_PER_KEY);
+    drop_tombstones_ = keyvi::util::mapGetBool(params_, MERGE_DROP_TOMBSTONES, false);
   }
 
   void Add(const std::string& filename) {
@@ -106,6 +115,9 @@ class DictionaryMerger final {
       throw std::invalid_argument("Dictionaries must have the same type.");
     }
 
+    // tombstones hide keys in older dictionaries, a dictionary without keys might still have tombstones
+    AddTombstones(filename, segments_pqueue_.size());
+
     // check whether dictionary is completely empty
     const auto segment_iterator = fsa::SegmentIterator(fsa::EntryIterator(fsa), segments_pqueue_.size());
     if (!segment_iterator) {
@@ -135,9 +147,15 @@ class DictionaryMerger final {
   void Merge(const std::string& filename) {
     Merge();
     generator_->WriteToFile(filename);
+    WriteKeyFilter(filename);
+    WriteTombstones(filename);
   }
 
   void Merge() {
+    if (key_filter_bits_per_key_ > 0) {
+      key_filter_.reset(new util::KeyFilter(GetTotalNumberOfKeys(), key_filter_bits_per_key_));
+    }
+
     if (append_merge_) {
       AppendMerge();
     } else {
@@ -159,6 +177,8 @@ class DictionaryMerger final {
       throw merger_exception("not merged yet");
     }
     generator_->WriteToFile(filename);
+    WriteKeyFilter(filename);
+    WriteTombstones(filename);
   }
 
   const MergeStats& GetStats() const { return stats_; }
@@ -173,6 +193,45 @@ class DictionaryMerger final {
   parameters_t params_;
   std::string manifest_ = std::string();
   MergeStats stats_;
+  size_t key_filter_bits_per_key_;
+  std::unique_ptr<util::KeyFilter> key_filter_;
+  bool drop_tombstones_;
+  // tombstones of all inputs: key -> the segment index below which the tombstone hides the key
+  std::map<std::string, size_t> tombstones_;
+
+  uint64_t GetTotalNumberOfKeys() const {
+    uint64_t number_of_keys = 0;
+    for (auto fsa : dicts_to_merge_) {
+      number_of_keys += fsa->GetNumberOfKeys();
+    }
+    return number_of_keys;
+  }
+
+  /**
+   * Write the key filter sidecar file if enabled.
+   */
+  void WriteKeyFilter(const std::string& filename) const {
+    if (key_filter_) {
+      key_filter_->WriteToFile(filename + KEY_FILTER_FILE_SUFFIX);
+    }
+  }
+
+  /**
+   * Write the tombstones that have to hide keys in older dictionaries, unless they should be dropped.
+   */
+  void WriteTombstones(const std::string& filename) {
+    if (drop_tombstones_ || tombstones_.empty()) {
+      return;
+    }
+
+    std::vector<std::string> sorted_keys;
+    sorted_keys.reserve(tombstones_.size());
+    for (const auto& tombstone : tombstones_) {
+      sorted_keys.push_back(tombstone.first);
+    }
+    index::internal::TombstonesFile::Write(filename, sorted_keys);
+    stats_.tombstones_ = sorted_keys.size();
+  }
 
   size_t GetTotalSparseArraySize() const {
     size_t sparse_array_size_sum = 0;
@@ -198,6 +257,30 @@ class DictionaryMerger final {
     return false;
   }
 
+  /**
+   * Check whether a tombstone of a newer dictionary hides the key, a key from a newer dictionary supersedes older
+   * tombstones.
+   */
+  bool KeyHiddenByTombstone(size_t segment_index, const std::string& key) {
+    if (tombstones_.empty()) {
+      return false;
+    }
+
+    auto tombstone = tombstones_.find(key);
+    if (tombstone == tombstones_.end()) {
+      return false;
+    }
+
+    if (segment_index < tombstone->second) {
+      ++stats_.deleted_keys_;
+      return true;
+    }
+
+    // the merged dictionary has the key, no need to hide it anymore
+    tombstones_.erase(tombstone);
+    return false;
+  }
+
   void CompleteMerge() {
     ValueStoreMergeT* value_store = new ValueStoreMergeT(params_);
     generator_ =
@@ -224,7 +307,8 @@ class DictionaryMerger final {
         }
       }
 
-      if (KeyDeleted(segment_it.segmentIndex(), top_key) == false) {
+      if (KeyDeleted(segment_it.segmentIndex(), top_key) == false &&
+          KeyHiddenByTombstone(segment_it.segmentIndex(), top_key) == false) {
         fsa::ValueHandle handle;
         handle.no_minimization_ = false;
 
@@ -237,6 +321,9 @@ class DictionaryMerger final {
 
         TRACE("Add key: %s", top_key.c_str());
         ++stats_.number_of_keys_;
+        if (key_filter_) {
+          key_filter_->Add(top_key);
+        }
         generator_->Add(std::move(top_key), handle);
       }
       if (++segment_it) {
@@ -274,7 +361,8 @@ class DictionaryMerger final {
         }
       }
 
-      if (KeyDeleted(segment_it.segmentIndex(), top_key) == false) {
+      if (KeyDeleted(segment_it.segmentIndex(), top_key) == false &&
+          KeyHiddenByTombstone(segment_it.segmentIndex(), top_key) == false) {
         fsa::ValueHandle handle;
         handle.no_minimization_ = false;
 
@@ -286,6 +374,9 @@ class DictionaryMerger final {
 
         TRACE("Add key: %s", top_key.c_str());
         ++stats_.number_of_keys_;
+        if (key_filter_) {
+          key_filter_->Add(top_key);
+        }
         generator_->Add(std::move(top_key), handle);
       }
       if (++segment_it) {
@@ -298,7 +389,18 @@ class DictionaryMerger final {
   }
 
   /**
-   * Load a file with deleted keys if it exists
+   * Load the tombstones of a dictionary, they hide the keys in dictionaries with a segment index below hides_below.
+   */
+  void AddTombstones(const std::string& filename, const size_t hides_below) {
+    for (std::string& key : index::internal::TombstonesFile::Read(filename)) {
+      // the newest tombstone wins
+      size_t& tombstone = tombstones_[std::move(key)];
+      tombstone = std::max(tombstone, hides_below);
+    }
+  }
+
+  /**
+   * Load a file with deleted keys and its journal if they exist
    */
   std::vector<std::string> TryLoadDeletedKeys(const std::string& filename) {
     std::vector<std::string> deleted_keys;
@@ -322,11 +424,19 @@ class DictionaryMerger final {
 
         unpacked_object.get().convert(deleted_keys);
       }
-
-      // sort in reverse order
-      std::sort(deleted_keys.begin(), deleted_keys.end(), std::greater<std::string>());
     }
 
+    // deletes that have not been compacted into the deleted keys file yet
+    uint64_t journal_epoch = 0;
+    size_t journal_offset = 0;
+    index::internal::DeletedKeysJournal::Tail(
+        index::internal::DeletedKeysJournal::JournalFilename(deleted_keys_file.string()), &journal_epoch,
+        &journal_offset, &deleted_keys);
+
+    // sort in reverse order, the journal might repeat keys of the deleted keys file
+    std::sort(deleted_keys.begin(), deleted_keys.end(), std::greater<std::string>());
+    deleted_keys.erase(std::unique(deleted_keys.begin(), deleted_keys.end()), deleted_keys.end());
+
     return deleted_keys;
   }
 };
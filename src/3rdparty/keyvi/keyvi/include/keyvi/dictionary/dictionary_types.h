@@ -67,6 +67,12 @@ using KeyOnlyDictionaryMerger = keyvi::dictionary::DictionaryMerger<dictionary_t
 
 using JsonDictionaryIndexCompiler = keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON>;
 
+using StringDictionaryIndexCompiler = keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::STRING>;
+
+using IntDictionaryIndexCompiler = keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::INT>;
+
+using KeyOnlyDictionaryIndexCompiler = keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::KEY_ONLY>;
+
 #ifndef KEYVI_REMOVE_DEPRECATED
 using IntDictionaryCompilerSmallData = IntDictionaryCompiler;
 
@@ -41,6 +41,14 @@ static const int KEYVI_FILE_VERSION_MAX = 2;
 // the current version of the file format
 static const int KEYVI_FILE_VERSION_CURRENT = 2;
 
+// key filter sidecar file
+static const char KEY_FILTER_FILE_MAGIC[] = "KEYVIKF1";
+static const size_t KEY_FILTER_FILE_MAGIC_LEN = 8;
+static const char KEY_FILTER_FILE_SUFFIX[] = ".kf";
+
+// tombstones sidecar file: keys deleted by a segment in all older segments
+static const char TOMBSTONES_FILE_SUFFIX[] = ".tk";
+
 // min version of the persistence part
 static const int KEYVI_FILE_PERSISTENCE_VERSION_MIN = 2;
 static const size_t NUMBER_OF_STATE_CODINGS = 255;
@@ -70,6 +78,9 @@ static const size_t DEFAULT_MEMORY_LIMIT_VALUE_STORE = 500 * 1024 * 1024;
 
 static const size_t DEFAULT_PARALLEL_SORT_THRESHOLD = 10000;
 
+// bits per key for the key filter sidecar, 0: do not write a key filter
+static const size_t DEFAULT_KEY_FILTER_BITS_PER_KEY = 0;
+
 // option key names
 static const char MEMORY_LIMIT_KEY[] = "memory_limit";
 static const char TEMPORARY_PATH_KEY[] = "temporary_path";
@@ -80,5 +91,8 @@ static const char SINGLE_PRECISION_FLOAT_KEY[] = "floating_point_precision";
 static const char PARALLEL_SORT_THRESHOLD_KEY[] = "parallel_sort_threshold";
 static const char MERGE_MODE[] = "merge_mode";
 static const char MERGE_APPEND[] = "append";
+static const char KEY_FILTER_BITS_PER_KEY[] = "key_filter_bits_per_key";
+static const char TOMBSTONES_KEY[] = "tombstones";
+static const char MERGE_DROP_TOMBSTONES[] = "drop_tombstones";
 
 #endif  // KEYVI_DICTIONARY_FSA_INTERNAL_CONSTANTS_H_
@@ -25,6 +25,7 @@
 #ifndef KEYVI_DICTIONARY_FSA_INTERNAL_JSON_VALUE_STORE_H_
 #define KEYVI_DICTIONARY_FSA_INTERNAL_JSON_VALUE_STORE_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -123,16 +124,25 @@ class JsonValueStoreMinimizationBase : public JsonValueStoreBase {
 };
 
 /**
- * Value store where the value is a json object.
+ * A json value encoded by JsonValueEncoder, with the hashcode used for minimization.
  */
-class JsonValueStore final : public JsonValueStoreMinimizationBase {
+struct EncodedJsonValue final {
+  std::string value_;
+  int32_t hashcode_ = 0;
+};
+
+/**
+ * Encodes json values the way the json value store persists them: msgpack, compressed above the threshold.
+ *
+ * Encoding does not depend on the state of the value store, values can be encoded on any thread and added later as
+ * EncodedJsonValue. An encoder must not be shared between threads, the compressors are not thread-safe.
+ */
+class JsonValueEncoder final {
  public:
-  explicit JsonValueStore(const keyvi::util::parameters_t& parameters = keyvi::util::parameters_t())
-      : JsonValueStoreMinimizationBase(parameters) {
-    compression_threshold_ = keyvi::util::mapGet(parameters_, COMPRESSION_THRESHOLD_KEY, 32);
-    std::string compressor = keyvi::util::mapGet<std::string>(parameters_, COMPRESSION_KEY, {});
-    minimize_ = keyvi::util::mapGetBool(parameters_, MINIMIZATION_KEY, true);
-    std::string float_mode = keyvi::util::mapGet<std::string>(parameters_, SINGLE_PRECISION_FLOAT_KEY, {});
+  explicit JsonValueEncoder(const keyvi::util::parameters_t& parameters = keyvi::util::parameters_t()) {
+    compression_threshold_ = keyvi::util::mapGet(parameters, COMPRESSION_THRESHOLD_KEY, 32);
+    std::string compressor = keyvi::util::mapGet<std::string>(parameters, COMPRESSION_KEY, {});
+    std::string float_mode = keyvi::util::mapGet<std::string>(parameters, SINGLE_PRECISION_FLOAT_KEY, {});
 
     if (float_mode == "single") {
       single_precision_float_ = true;
@@ -148,24 +158,97 @@ class JsonValueStore final : public JsonValueStoreMinimizationBase {
                   raw_compressor_.get(), std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
   }
 
+  JsonValueEncoder& operator=(JsonValueEncoder const&) = delete;
+  JsonValueEncoder(const JsonValueEncoder& that) = delete;
+
+  /**
+   * Encode the value, the returned buffer is only valid until the next call.
+   */
+  const compression::buffer_t& Encode(const std::string& value) {
+    keyvi::util::EncodeJsonValue(long_compress_, short_compress_, &msgpack_buffer_, &string_buffer_, value,
+                                 single_precision_float_, compression_threshold_);
+    return string_buffer_;
+  }
+
+  void Encode(const std::string& value, EncodedJsonValue* encoded_value) {
+    Encode(value);
+    encoded_value->value_.assign(string_buffer_.data(), string_buffer_.size());
+    encoded_value->hashcode_ =
+        RawPointerForCompare<MemoryMapManager>::HashCode(string_buffer_.data(), string_buffer_.size());
+  }
+
+  std::string CompressorName() const { return compressor_->name(); }
+
+ private:
+  /*
+   * Compressors & the associated compression functions. Ugly, but
+   * needed for EncodeJsonValue.
+   */
+  std::unique_ptr<compression::CompressionStrategy> compressor_;
+  std::unique_ptr<compression::CompressionStrategy> raw_compressor_;
+  std::function<void(compression::buffer_t*, const char*, size_t)> long_compress_;
+  std::function<void(compression::buffer_t*, const char*, size_t)> short_compress_;
+  bool single_precision_float_ = false;
+  size_t compression_threshold_;
+
+  compression::buffer_t string_buffer_;
+  msgpack::sbuffer msgpack_buffer_;
+};
+
+/**
+ * Value store where the value is a json object.
+ */
+class JsonValueStore final : public JsonValueStoreMinimizationBase {
+ public:
+  explicit JsonValueStore(const keyvi::util::parameters_t& parameters = keyvi::util::parameters_t())
+      : JsonValueStoreMinimizationBase(parameters), encoder_(parameters) {
+    minimize_ = keyvi::util::mapGetBool(parameters_, MINIMIZATION_KEY, true);
+  }
+
   /**
    * Simple implementation of a value store for json values:
    * todo: performance improvements?
    */
   uint64_t AddValue(const value_t& value, bool* no_minimization) {
-    keyvi::util::EncodeJsonValue(long_compress_, short_compress_, &msgpack_buffer_, &string_buffer_, value,
-                                 single_precision_float_, compression_threshold_);
+    const compression::buffer_t& buffer = encoder_.Encode(value);
+    const int32_t hashcode =
+        minimize_ ? RawPointerForCompare<MemoryMapManager>::HashCode(buffer.data(), buffer.size()) : 0;
+
+    return AddEncodedValue(buffer.data(), buffer.size(), hashcode, no_minimization);
+  }
+
+  /**
+   * Add a value encoded upfront by a JsonValueEncoder created with the same parameters.
+   */
+  uint64_t AddEncodedValue(const EncodedJsonValue& value, bool* no_minimization) {
+    return AddEncodedValue(value.value_.data(), value.value_.size(), value.hashcode_, no_minimization);
+  }
+
+  void Write(std::ostream& stream) {
+    ValueStoreProperties properties(0, values_buffer_size_, number_of_values_, number_of_unique_values_,
+                                    encoder_.CompressorName());
 
+    properties.WriteAsJsonV2(stream);
+    TRACE("Wrote JSON header, stream at %d", stream.tellp());
+
+    values_extern_->Write(stream, values_buffer_size_);
+  }
+
+ private:
+  JsonValueEncoder encoder_;
+  bool minimize_ = true;
+
+  uint64_t AddEncodedValue(const char* value, const size_t value_size, const int32_t hashcode,
+                           bool* no_minimization) {
     ++number_of_values_;
 
     if (!minimize_) {
       TRACE("Minimization is turned off.");
       *no_minimization = true;
-      return CreateNewValue();
+      return CreateNewValue(value, value_size);
     }
 
-    const RawPointerForCompare<MemoryMapManager> stp(string_buffer_.data(), string_buffer_.size(),
-                                                     values_extern_.get());
+    const RawPointerForCompare<MemoryMapManager> stp(value, value_size, values_extern_.get(), hashcode);
     const RawPointer<> p = hash_.Get(stp);
 
     if (!p.IsEmpty()) {
@@ -178,49 +261,22 @@ class JsonValueStore final : public JsonValueStoreMinimizationBase {
     TRACE("New unique value");
     ++number_of_unique_values_;
 
-    uint64_t pt = CreateNewValue();
+    uint64_t pt = CreateNewValue(value, value_size);
 
-    TRACE("add value to hash at %d, length %d", pt, string_buffer_.size());
-    hash_.Add(RawPointer<>(pt, stp.GetHashcode(), string_buffer_.size()));
+    TRACE("add value to hash at %d, length %d", pt, value_size);
+    hash_.Add(RawPointer<>(pt, stp.GetHashcode(), value_size));
 
     return pt;
   }
 
-  void Write(std::ostream& stream) {
-    ValueStoreProperties properties(0, values_buffer_size_, number_of_values_, number_of_unique_values_,
-                                    compressor_->name());
-
-    properties.WriteAsJsonV2(stream);
-    TRACE("Wrote JSON header, stream at %d", stream.tellp());
-
-    values_extern_->Write(stream, values_buffer_size_);
-  }
-
- private:
-  /*
-   * Compressors & the associated compression functions. Ugly, but
-   * needed for EncodeJsonValue.
-   */
-  std::unique_ptr<compression::CompressionStrategy> compressor_;
-  std::unique_ptr<compression::CompressionStrategy> raw_compressor_;
-  std::function<void(compression::buffer_t*, const char*, size_t)> long_compress_;
-  std::function<void(compression::buffer_t*, const char*, size_t)> short_compress_;
-  bool single_precision_float_ = false;
-  size_t compression_threshold_;
-  bool minimize_ = true;
-
-  compression::buffer_t string_buffer_;
-  msgpack::sbuffer msgpack_buffer_;
-
- private:
-  uint64_t CreateNewValue() {
+  uint64_t CreateNewValue(const char* value, const size_t value_size) {
     uint64_t pt = static_cast<uint64_t>(values_buffer_size_);
     size_t length;
 
-    keyvi::util::encodeVarint(string_buffer_.size(), values_extern_.get(), &length);
+    keyvi::util::encodeVarint(value_size, values_extern_.get(), &length);
     values_buffer_size_ += length;
-    values_extern_->Append(reinterpret_cast<const void*>(string_buffer_.data()), string_buffer_.size());
-    values_buffer_size_ += string_buffer_.size();
+    values_extern_->Append(reinterpret_cast<const void*>(value), value_size);
+    values_buffer_size_ += value_size;
 
     return pt;
   }
@@ -80,17 +80,24 @@ template <class PersistenceT, class HashCodeTypeT = int32_t>
 struct RawPointerForCompare final {
  public:
   RawPointerForCompare(const char* value, size_t value_size, PersistenceT* persistence)
-      : value_(value), value_size_(value_size), persistence_(persistence) {
+      : RawPointerForCompare(value, value_size, persistence, HashCode(value, value_size)) {}
+
+  /**
+   * Create with a hashcode calculated upfront by HashCode(), e.g. on a different thread.
+   */
+  RawPointerForCompare(const char* value, size_t value_size, PersistenceT* persistence, HashCodeTypeT hashcode)
+      : value_(value), value_size_(value_size), persistence_(persistence), hashcode_(hashcode) {}
+
+  static HashCodeTypeT HashCode(const char* value, size_t value_size) {
     // calculate a hashcode
     HashCodeTypeT h = 31;
 
-    for (size_t i = 0; i < value_size_; ++i) {
+    for (size_t i = 0; i < value_size; ++i) {
       h = (h * 54059) ^ (value[i] * 76963);
     }
 
     TRACE("hashcode %d", h);
-
-    hashcode_ = h;
+    return h;
   }
 
   HashCodeTypeT GetHashcode() const { return hashcode_; }
@@ -0,0 +1,296 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * key_arena.h
+ *
+ *  Created on: Jul 28, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_DICTIONARY_UTIL_KEY_ARENA_H_
+#define KEYVI_DICTIONARY_UTIL_KEY_ARENA_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>  //NOLINT
+#include <utility>
+#include <vector>
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace util {
+
+/**
+ * Keys and values of a compiler batch, the keys are stored back to back in one buffer.
+ *
+ * Every key gets a small, fixed size entry with its position in the buffer, the first bytes of the key as integer and
+ * the value. Sorting moves entries only: the integer prefix decides most comparisons, the buffer is only touched if
+ * the prefixes are equal. The entries are radix sorted (MSD) by the prefix, buckets that are small or share the full
+ * prefix are sorted by comparison.
+ *
+ * The offset of a key in the buffer grows with every append, ties between equal keys are broken by it, so the sort
+ * keeps the insertion order of equal keys. As the order is total, the result does not depend on how the work is split,
+ * large batches get partitioned by the leading prefix bytes and the partitions are sorted in parallel.
+ */
+template <typename ValueT>
+class KeyArena final {
+ public:
+  KeyArena() : keys_(), entries_() {}
+
+  KeyArena& operator=(KeyArena const&) = delete;
+  KeyArena(const KeyArena& that) = delete;
+
+  void Append(const std::string& key, const ValueT& value) {
+    entries_.push_back(Entry{Prefix(key), keys_.size(), static_cast<uint32_t>(key.size()), value});
+    keys_.append(key);
+  }
+
+  /**
+   * Sort by key, equal keys keep the order they have been appended in.
+   *
+   * @param parallel_sort_threshold sort in parallel if there are more entries, 0 to always sort single threaded
+   */
+  void Sort(const size_t parallel_sort_threshold = 0) {
+    if (parallel_sort_threshold == 0 || entries_.size() <= parallel_sort_threshold) {
+      RadixSort(entries_.data(), entries_.data() + entries_.size(), 0);
+    } else {
+      ParallelSort(parallel_sort_threshold);
+    }
+  }
+
+  /**
+   * Call the given function for every distinct key in sorted order with the value appended last for that key, the key
+   * is only valid during the call. Requires a sorted arena.
+   */
+  template <typename FuncT>
+  void ForEachUnique(FuncT func) const {
+    std::string key;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      if (i + 1 < entries_.size() && KeyEquals(entries_[i], entries_[i + 1])) {
+        continue;
+      }
+      key.assign(keys_.data() + entries_[i].offset_, entries_[i].length_);
+      func(key, entries_[i].value_);
+    }
+  }
+
+  size_t size() const { return entries_.size(); }
+
+  bool empty() const { return entries_.empty(); }
+
+  void clear() {
+    keys_.clear();
+    keys_.shrink_to_fit();
+    entries_.clear();
+    entries_.shrink_to_fit();
+  }
+
+  /**
+   * Memory usage in bytes, without the object itself.
+   */
+  size_t SizeInBytes() const { return keys_.capacity() + entries_.capacity() * sizeof(Entry); }
+
+ private:
+  static const size_t kPrefixSize = sizeof(uint64_t);
+
+  // buckets below this size are sorted by comparison
+  static const size_t kMinRadixSortSize = 64;
+
+  struct Entry {
+    uint64_t prefix_;  // first bytes of the key, big endian and zero padded
+    uint64_t offset_;  // position in the buffer, grows with every append
+    uint32_t length_;
+    ValueT value_;
+  };
+
+  struct SortTask {
+    Entry* begin_;
+    Entry* end_;
+    size_t byte_;
+  };
+
+  std::string keys_;
+  std::vector<Entry> entries_;
+
+  static uint64_t Prefix(const std::string& key) {
+    uint64_t prefix = 0;
+    const size_t length = key.size() < kPrefixSize ? key.size() : kPrefixSize;
+    for (size_t i = 0; i < length; ++i) {
+      prefix |= static_cast<uint64_t>(static_cast<uint8_t>(key[i])) << (8 * (kPrefixSize - 1 - i));
+    }
+    return prefix;
+  }
+
+  static size_t PrefixByte(const uint64_t prefix, const size_t byte) {
+    return (prefix >> (8 * (kPrefixSize - 1 - byte))) & 0xff;
+  }
+
+  bool KeyEquals(const Entry& a, const Entry& b) const {
+    return a.prefix_ == b.prefix_ && a.length_ == b.length_ &&
+           (a.length_ <= kPrefixSize || std::memcmp(keys_.data() + a.offset_ + kPrefixSize,
+                                                    keys_.data() + b.offset_ + kPrefixSize,
+                                                    a.length_ - kPrefixSize) == 0);
+  }
+
+  bool Less(const Entry& a, const Entry& b) const {
+    if (a.prefix_ != b.prefix_) {
+      return a.prefix_ < b.prefix_;
+    }
+
+    // equal prefixes: the first min(length) bytes are equal up to the prefix size
+    const size_t common_length = std::min(a.length_, b.length_);
+    if (common_length > kPrefixSize) {
+      const int cmp = std::memcmp(keys_.data() + a.offset_ + kPrefixSize, keys_.data() + b.offset_ + kPrefixSize,
+                                  common_length - kPrefixSize);
+      if (cmp != 0) {
+        return cmp < 0;
+      }
+    }
+
+    if (a.length_ != b.length_) {
+      return a.length_ < b.length_;
+    }
+    return a.offset_ < b.offset_;
+  }
+
+  void ComparisonSort(Entry* begin, Entry* end) const {
+    std::sort(begin, end, [this](const Entry& a, const Entry& b) { return Less(a, b); });
+  }
+
+  /**
+   * Distribute the entries into buckets by the given byte of the prefix, in-place (american flag sort).
+   */
+  static void Partition(Entry* begin, Entry* end, const size_t byte, size_t counts[256]) {
+    std::fill(counts, counts + 256, 0);
+    for (Entry* it = begin; it != end; ++it) {
+      ++counts[PrefixByte(it->prefix_, byte)];
+    }
+
+    Entry* heads[256];
+    Entry* tails[256];
+    Entry* position = begin;
+    for (size_t bucket = 0; bucket < 256; ++bucket) {
+      heads[bucket] = position;
+      position += counts[bucket];
+      tails[bucket] = position;
+    }
+
+    for (size_t bucket = 0; bucket < 256; ++bucket) {
+      while (heads[bucket] != tails[bucket]) {
+        const size_t target = PrefixByte(heads[bucket]->prefix_, byte);
+        if (target == bucket) {
+          ++heads[bucket];
+        } else {
+          std::swap(*heads[bucket], *heads[target]++);
+        }
+      }
+    }
+  }
+
+  /**
+   * MSD radix sort starting at the given byte of the prefix.
+   */
+  void RadixSort(Entry* begin, Entry* end, const size_t byte) const {
+    const size_t size = end - begin;
+    if (size < 2) {
+      return;
+    }
+
+    if (size < kMinRadixSortSize || byte == kPrefixSize) {
+      ComparisonSort(begin, end);
+      return;
+    }
+
+    size_t counts[256];
+    Partition(begin, end, byte, counts);
+
+    Entry* position = begin;
+    for (size_t bucket = 0; bucket < 256; ++bucket) {
+      RadixSort(position, position + counts[bucket], byte + 1);
+      position += counts[bucket];
+    }
+  }
+
+  /**
+   * Partition until no partition is bigger than a fraction of the batch, then sort the partitions in parallel.
+   *
+   * Keys that share the full prefix end up in one partition, which is sorted by a single thread.
+   */
+  void ParallelSort(const size_t parallel_sort_threshold) {
+    const size_t number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t max_task_size = std::max(parallel_sort_threshold, entries_.size() / (4 * number_of_threads));
+
+    std::vector<SortTask> tasks;
+    std::vector<SortTask> to_partition{SortTask{entries_.data(), entries_.data() + entries_.size(), 0}};
+    size_t counts[256];
+
+    while (!to_partition.empty()) {
+      const SortTask task = to_partition.back();
+      to_partition.pop_back();
+
+      if (static_cast<size_t>(task.end_ - task.begin_) <= max_task_size || task.byte_ == kPrefixSize) {
+        tasks.push_back(task);
+        continue;
+      }
+
+      Partition(task.begin_, task.end_, task.byte_, counts);
+      Entry* position = task.begin_;
+      for (size_t bucket = 0; bucket < 256; ++bucket) {
+        if (counts[bucket] > 1) {
+          to_partition.push_back(SortTask{position, position + counts[bucket], task.byte_ + 1});
+        }
+        position += counts[bucket];
+      }
+    }
+
+    // biggest tasks first to balance the load
+    std::sort(tasks.begin(), tasks.end(),
+              [](const SortTask& a, const SortTask& b) { return (a.end_ - a.begin_) > (b.end_ - b.begin_); });
+    TRACE("sorting %ld entries in %ld partitions", entries_.size(), tasks.size());
+
+    std::atomic<size_t> next_task(0);
+    auto worker = [this, &tasks, &next_task]() {
+      for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+        RadixSort(tasks[i].begin_, tasks[i].end_, tasks[i].byte_);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(number_of_threads, tasks.size()); ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+};
+
+} /* namespace util */
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_UTIL_KEY_ARENA_H_
@@ -0,0 +1,211 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * key_filter.h
+ *
+ *  Created on: Jun 30, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_DICTIONARY_UTIL_KEY_FILTER_H_
+#define KEYVI_DICTIONARY_UTIL_KEY_FILTER_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/util/endian.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace util {
+
+/**
+ * Blocked bloom filter over the keys of a dictionary, stored as sidecar file next to it.
+ *
+ * All probes for a key hit the same 512 bit block (one cache line), a lookup costs one cache miss. With 10 bits per
+ * key the false positive rate is about 1%. The hash function is part of the file format and must not change.
+ *
+ * File format (little endian): magic, number of blocks (uint64), number of probes (uint64), blocks.
+ */
+class KeyFilter final {
+ public:
+  /**
+   * Create an empty filter.
+   *
+   * @param number_of_keys expected number of keys, more keys increase the false positive rate
+   * @param bits_per_key bits to use per key
+   */
+  KeyFilter(const size_t number_of_keys, const size_t bits_per_key)
+      : number_of_blocks_(NumberOfBlocks(number_of_keys, bits_per_key)),
+        number_of_probes_(NumberOfProbes(bits_per_key)),
+        blocks_(number_of_blocks_ * kWordsPerBlock, 0) {}
+
+  KeyFilter& operator=(KeyFilter const&) = delete;
+  KeyFilter(const KeyFilter& that) = delete;
+
+  void Add(const std::string& key) {
+    const uint64_t hash = Hash(key);
+    uint64_t* block = &blocks_[BlockIndex(hash) * kWordsPerBlock];
+
+    const uint32_t step = static_cast<uint32_t>(hash >> 17) | 1;
+    uint32_t bit = static_cast<uint32_t>(hash);
+    for (size_t i = 0; i < number_of_probes_; ++i, bit += step) {
+      block[(bit % kBitsPerBlock) / 64] |= uint64_t(1) << (bit % 64);
+    }
+  }
+
+  /**
+   * Check the key, false if the key is definitely not in the dictionary.
+   */
+  bool MayContain(const std::string& key) const {
+    const uint64_t hash = Hash(key);
+    const uint64_t* block = &blocks_[BlockIndex(hash) * kWordsPerBlock];
+
+    const uint32_t step = static_cast<uint32_t>(hash >> 17) | 1;
+    uint32_t bit = static_cast<uint32_t>(hash);
+    for (size_t i = 0; i < number_of_probes_; ++i, bit += step) {
+      if ((block[(bit % kBitsPerBlock) / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t SizeInBytes() const { return blocks_.size() * sizeof(uint64_t); }
+
+  /**
+   * Write the filter, the file is written to a temporary file first and then moved into place.
+   */
+  void WriteToFile(const std::string& filename) const {
+    const std::string swap_filename = filename + "-swap";
+    {
+      std::ofstream out_stream(swap_filename, std::ios::binary);
+      out_stream.write(KEY_FILTER_FILE_MAGIC, KEY_FILTER_FILE_MAGIC_LEN);
+      WriteWord(&out_stream, number_of_blocks_);
+      WriteWord(&out_stream, number_of_probes_);
+      for (const uint64_t word : blocks_) {
+        WriteWord(&out_stream, word);
+      }
+    }
+    std::rename(swap_filename.c_str(), filename.c_str());
+  }
+
+  /**
+   * Load a filter, returns nullptr if the file does not exist or is not a valid filter.
+   */
+  static std::shared_ptr<KeyFilter> FromFile(const std::string& filename) {
+    std::ifstream in_stream(filename, std::ios::binary);
+    if (!in_stream.good()) {
+      return std::shared_ptr<KeyFilter>();
+    }
+
+    char magic[KEY_FILTER_FILE_MAGIC_LEN];
+    in_stream.read(magic, KEY_FILTER_FILE_MAGIC_LEN);
+    if (!in_stream.good() || std::memcmp(magic, KEY_FILTER_FILE_MAGIC, KEY_FILTER_FILE_MAGIC_LEN) != 0) {
+      TRACE("invalid key filter file %s", filename.c_str());
+      return std::shared_ptr<KeyFilter>();
+    }
+
+    const uint64_t number_of_blocks = ReadWord(&in_stream);
+    const uint64_t number_of_probes = ReadWord(&in_stream);
+    if (!in_stream.good() || number_of_blocks == 0 || number_of_probes == 0 || number_of_probes > kMaxProbes) {
+      return std::shared_ptr<KeyFilter>();
+    }
+
+    std::shared_ptr<KeyFilter> filter = std::make_shared<KeyFilter>(0, 0);
+    filter->number_of_blocks_ = number_of_blocks;
+    filter->number_of_probes_ = number_of_probes;
+    filter->blocks_.resize(number_of_blocks * kWordsPerBlock);
+    for (uint64_t& word : filter->blocks_) {
+      word = ReadWord(&in_stream);
+    }
+
+    if (in_stream.fail()) {
+      TRACE("truncated key filter file %s", filename.c_str());
+      return std::shared_ptr<KeyFilter>();
+    }
+    return filter;
+  }
+
+  /**
+   * Stable 64 bit hash: FNV-1a followed by the murmur3 finalizer.
+   */
+  static inline uint64_t Hash(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : key) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+ private:
+  static const size_t kBitsPerBlock = 512;
+  static const size_t kWordsPerBlock = kBitsPerBlock / 64;
+  static const size_t kMaxProbes = 16;
+
+  size_t number_of_blocks_;
+  size_t number_of_probes_;
+  std::vector<uint64_t> blocks_;
+
+  static size_t NumberOfBlocks(const size_t number_of_keys, const size_t bits_per_key) {
+    const size_t number_of_blocks = (number_of_keys * bits_per_key + kBitsPerBlock - 1) / kBitsPerBlock;
+    return number_of_blocks > 0 ? number_of_blocks : 1;
+  }
+
+  // optimal number of probes: bits per key * ln(2)
+  static size_t NumberOfProbes(const size_t bits_per_key) {
+    const size_t number_of_probes = std::lround(bits_per_key * 0.69);
+    return number_of_probes < 1 ? 1 : (number_of_probes > kMaxProbes ? kMaxProbes : number_of_probes);
+  }
+
+  inline size_t BlockIndex(const uint64_t hash) const { return ((hash >> 32) * number_of_blocks_) >> 32; }
+
+  static void WriteWord(std::ofstream* stream, const uint64_t word) {
+    const uint64_t le_word = htole64(word);
+    stream->write(reinterpret_cast<const char*>(&le_word), sizeof(le_word));
+  }
+
+  static uint64_t ReadWord(std::ifstream* stream) {
+    uint64_t le_word = 0;
+    stream->read(reinterpret_cast<char*>(&le_word), sizeof(le_word));
+    return le64toh(le_word);
+  }
+};
+
+} /* namespace util */
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_UTIL_KEY_FILTER_H_
@@ -35,11 +35,22 @@ static const char INDEX_MAX_SEGMENTS[] = "max_segments";
 static const char SEGMENT_COMPILE_KEY_THRESHOLD[] = "segment_compile_key_threshold";
 static const char SEGMENT_EXTERNAL_MERGE_KEY_THRESHOLD[] = "segment_external_merge_key_threshold";
 static const char MAX_CONCURRENT_MERGES[] = "max_concurrent_merges";
+static const char MAX_CONCURRENT_COMPILES[] = "max_concurrent_compiles";
+static const char VALUE_CACHE_SIZE[] = "value_cache_size";
+static const char VALUE_STORE_TYPE[] = "value_store_type";
 
 // defaults
 static const size_t DEFAULT_REFRESH_INTERVAL = 1000ul;
 static const size_t DEFAULT_COMPILE_KEY_THRESHOLD = 10000ul;
 static const size_t DEFAULT_EXTERNAL_MERGE_KEY_THRESHOLD = 100000ul;
+// value cache size in bytes, disabled by default
+static const size_t DEFAULT_VALUE_CACHE_SIZE = 0ul;
+// bits per key for the key filter of a segment, 0 disables the filter
+static const size_t DEFAULT_INDEX_KEY_FILTER_BITS_PER_KEY = 10ul;
+// write deletes as tombstones into new segments instead of marking them deleted in all older segments
+static const bool DEFAULT_INDEX_TOMBSTONES = false;
+// value store of the segments: json, string, int or key_only, fixed when the index is created
+static const char DEFAULT_VALUE_STORE_TYPE[] = "json";
 #if defined(_WIN32)
 static const char DEFAULT_KEYVIMERGER_BIN[] = "keyvimerger.exe";
 #else
@@ -52,4 +63,7 @@ static const size_t SPINLOCK_WAIT_FOR_SEGMENT_MERGES_MS = 10;
 // max parallel process for segment merging
 static const size_t MAX_CONCURRENT_MERGES_DEFAULT = 8;
 
+// max segments compiled in the background while new writes go into the next segment
+static const size_t DEFAULT_MAX_CONCURRENT_COMPILES = 2;
+
 #endif  // KEYVI_INDEX_CONSTANTS_H_
@@ -117,6 +117,16 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
    */
   void Delete(const std::string& key) { Payload().Delete(key); }
 
+  /**
+   * Delete multiple keys
+   *
+   * @param keys the keys, the container must implement an iterator over the keys, e.g. `std::vector<std::string>`
+   */
+  template <typename ContainerType>
+  void MDelete(const std::shared_ptr<ContainerType>& keys) {
+    Payload().Delete(keys);
+  }
+
   /**
    * Flush the index, persists all pending writes and makes the accessible.
    *
@@ -139,6 +149,12 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
     Payload().ForceMerge(max_segments);
   }
 
+  /**
+   * Get the generation of the index, which changes whenever a write becomes visible. Can be used to invalidate
+   * cached results.
+   */
+  size_t Generation() { return Payload().Generation(); }
+
  private:
   boost::filesystem::path index_directory_;
   boost::filesystem::path index_toc_file_;
@@ -40,6 +40,7 @@
 #include "keyvi/dictionary/matching/near_matching.h"
 #include "keyvi/index/internal/index_lookup_util.h"
 #include "keyvi/index/internal/read_only_segment.h"
+#include "keyvi/index/internal/value_cache.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -65,19 +66,21 @@ class BaseIndexReader {
    * @param key the key
    */
   dictionary::Match operator[](const std::string& key) {
+    ValueCache* value_cache = payload_.GetValueCache();
+    if (!value_cache) {
+      return Lookup(key);
+    }
+
     dictionary::Match match;
-    const_segments_t segments = payload_.Segments();
+    uint64_t epoch = 0;
 
-    for (auto it = segments->crbegin(); it != segments->crend(); ++it) {
-      match = (*it)->GetDictionary()->operator[](key);
-      if (!match.IsEmpty()) {
-        if ((*it)->IsDeleted(key)) {
-          return dictionary::Match();
-        }
-        return match;
-      }
+    // the epoch must be taken before reading the segments
+    if (value_cache->Get(key, &match, &epoch)) {
+      return match;
     }
 
+    match = Lookup(key);
+    value_cache->Put(key, epoch, match);
     return match;
   }
 
@@ -87,8 +90,18 @@ class BaseIndexReader {
    * @param key the key
    */
   bool Contains(const std::string& key) {
+    if (payload_.GetValueCache()) {
+      return !operator[](key).IsEmpty();
+    }
+
     const_segments_t segments = payload_.Segments();
     for (auto it = segments->crbegin(); it != segments->crend(); it++) {
+      if ((*it)->HasTombstone(key)) {
+        return false;
+      }
+      if (!(*it)->MayContain(key)) {
+        continue;
+      }
       if ((*it)->GetDictionary()->Contains(key)) {
         return !(*it)->IsDeleted(key);
       }
@@ -135,18 +148,13 @@ class BaseIndexReader {
               std::get<0>(fsa_start_state_payloads[0]), std::get<1>(fsa_start_state_payloads[0]), query,
               minimum_exact_prefix, greedy));
 
-      for (auto it = segments->crbegin(); it != segments->crend(); it++) {
-        if ((*it)->GetDictionary()->GetFsa() == std::get<0>(fsa_start_state_payloads[0])) {
-          typename SegmentT::deleted_ptr_t deleted_keys = (*it)->DeletedKeys();
-          if ((*it)->DeletedKeysSize() > 0) {
-            auto func = [near_matcher, deleted_keys]() { return NextFilteredMatchSingle(near_matcher, deleted_keys); };
-
-            // check if first match is a deleted key and reset in case
-            return dictionary::MatchIterator::MakeIteratorPair(func,
-                                                               FirstFilteredMatchSingle(near_matcher, deleted_keys));
-          }
-          break;  // else: found the fsa, but segments has no deletes
-        }
+      auto deleted_keys_map = CreatedDeletedKeysMap(segments, fsa_start_state_payloads);
+      if (deleted_keys_map.size() > 0) {
+        auto deleted_keys = deleted_keys_map.begin()->second;
+        auto func = [near_matcher, deleted_keys]() { return NextFilteredMatchSingle(near_matcher, deleted_keys); };
+
+        // check if first match is a deleted key and reset in case
+        return dictionary::MatchIterator::MakeIteratorPair(func, FirstFilteredMatchSingle(near_matcher, deleted_keys));
       }
 
       auto func = [near_matcher]() { return near_matcher->NextMatch(); };
@@ -204,20 +212,14 @@ class BaseIndexReader {
                                                                  fsa_start_state_pairs[0].second, query,
                                                                  max_edit_distance, minimum_exact_prefix));
 
-      for (auto it = segments->crbegin(); it != segments->crend(); it++) {
-        if ((*it)->GetDictionary()->GetFsa() == fsa_start_state_pairs[0].first) {
-          typename SegmentT::deleted_ptr_t deleted_keys = (*it)->DeletedKeys();
-          if ((*it)->DeletedKeysSize() > 0) {
-            auto func = [fuzzy_matcher, deleted_keys]() {
-              return NextFilteredMatchSingle(fuzzy_matcher, deleted_keys);
-            };
-
-            // check if first match is a deleted key and reset in case
-            return dictionary::MatchIterator::MakeIteratorPair(func,
-                                                               FirstFilteredMatchSingle(fuzzy_matcher, deleted_keys));
-          }
-          break;  // else: found the fsa, but segments has no deletes
-        }
+      auto deleted_keys_map = CreatedDeletedKeysMap(segments, fsa_start_state_pairs);
+      if (deleted_keys_map.size() > 0) {
+        auto deleted_keys = deleted_keys_map.begin()->second;
+        auto func = [fuzzy_matcher, deleted_keys]() { return NextFilteredMatchSingle(fuzzy_matcher, deleted_keys); };
+
+        // check if first match is a deleted key and reset in case
+        return dictionary::MatchIterator::MakeIteratorPair(func,
+                                                           FirstFilteredMatchSingle(fuzzy_matcher, deleted_keys));
       }
 
       auto func = [fuzzy_matcher]() { return fuzzy_matcher->NextMatch(); };
@@ -252,6 +254,30 @@ class BaseIndexReader {
  private:
   PayloadT payload_;
 
+  dictionary::Match Lookup(const std::string& key) {
+    dictionary::Match match;
+    const_segments_t segments = payload_.Segments();
+
+    for (auto it = segments->crbegin(); it != segments->crend(); ++it) {
+      // a tombstone hides the key in all older segments
+      if ((*it)->HasTombstone(key)) {
+        return dictionary::Match();
+      }
+      if (!(*it)->MayContain(key)) {
+        continue;
+      }
+      match = (*it)->GetDictionary()->operator[](key);
+      if (!match.IsEmpty()) {
+        if ((*it)->IsDeleted(key)) {
+          return dictionary::Match();
+        }
+        return match;
+      }
+    }
+
+    return match;
+  }
+
   // friend for unit testing only
   friend class keyvi::index::unit_test::IndexFriend;
 };
@@ -0,0 +1,156 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * compile_job.h
+ *
+ *  Created on: Aug 4, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
+#define KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "keyvi/index/internal/segment.h"
+#include "keyvi/index/internal/segment_compiler.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Compilation of a sealed compiler into a new segment, running in its own thread.
+ *
+ * The writer keeps accepting writes into a new compiler meanwhile. Writes and deletes that happen after sealing are
+ * newer than the content of the job: writes end up in newer segments, deletes are collected and applied to the
+ * segment when it gets published.
+ */
+class CompileJob final {
+ public:
+  /**
+   * @param compiler the sealed compiler, no more keys must be added
+   * @param output_filename the file to write the segment to
+   * @param written_keys keys to invalidate in the value cache once the segment is visible
+   */
+  explicit CompileJob(const std::shared_ptr<SegmentCompilerInterface>& compiler,
+                      const boost::filesystem::path& output_filename, std::vector<std::string>&& written_keys)
+      : compiler_(compiler),
+        output_filename_(output_filename),
+        written_keys_(std::move(written_keys)),
+        deleted_keys_(),
+        done_(false),
+        exception_(),
+        compile_thread_() {}
+
+  ~CompileJob() { Finalize(); }
+
+  CompileJob() = delete;
+  CompileJob& operator=(CompileJob const&) = delete;
+  CompileJob(const CompileJob& that) = delete;
+
+  /**
+   * Start compilation.
+   *
+   * @param on_done called from the compile thread after the segment has been written
+   */
+  void Run(const std::function<void()>& on_done) {
+    compile_thread_ = std::thread([this, on_done]() {
+      try {
+        TRACE("compiling %s", output_filename_.string().c_str());
+        compiler_->Compile();
+        compiler_->WriteToFile(output_filename_.string());
+      } catch (...) {
+        exception_ = std::current_exception();
+      }
+
+      // free resources
+      compiler_.reset();
+      done_ = true;
+
+      if (on_done) {
+        on_done();
+      }
+    });
+  }
+
+  bool Done() const { return done_; }
+
+  /**
+   * Wait for the compilation to finish.
+   */
+  void Finalize() {
+    if (compile_thread_.joinable()) {
+      compile_thread_.join();
+    }
+  }
+
+  /**
+   * Create the compiled segment with all deletes that happened after sealing, rethrows if compilation failed.
+   */
+  segment_t CompiledSegment() {
+    Finalize();
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+
+    segment_t segment(new Segment(output_filename_, true));
+    if (!deleted_keys_.empty()) {
+      std::sort(deleted_keys_.begin(), deleted_keys_.end());
+      deleted_keys_.erase(std::unique(deleted_keys_.begin(), deleted_keys_.end()), deleted_keys_.end());
+      segment->DeleteKeys(deleted_keys_);
+    }
+
+    return segment;
+  }
+
+  void DeleteKey(const std::string& key) { deleted_keys_.push_back(key); }
+
+  bool HasDeletedKeys() const { return !deleted_keys_.empty(); }
+
+  std::vector<std::string>* WrittenKeys() { return &written_keys_; }
+
+ private:
+  std::shared_ptr<SegmentCompilerInterface> compiler_;
+  boost::filesystem::path output_filename_;
+  std::vector<std::string> written_keys_;
+  // only accessed by the writer thread
+  std::vector<std::string> deleted_keys_;
+  std::atomic_bool done_;
+  std::exception_ptr exception_;
+  std::thread compile_thread_;
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
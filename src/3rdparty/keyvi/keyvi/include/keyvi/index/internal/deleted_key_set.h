@@ -0,0 +1,307 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * deleted_key_set.h
+ *
+ *  Created on: Jul 7, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
+#define KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "keyvi/dictionary/util/key_filter.h"
+#include "keyvi/util/vint.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Immutable, compact set of deleted keys.
+ *
+ * Keys are kept sorted and front coded in blocks of kBlockSize keys: every key stores the length of the prefix it
+ * shares with its predecessor and the remaining suffix, the first key of a block is stored in full. A lookup checks a
+ * bloom filter first, so the common case - the key is not deleted - does not touch the keys at all. Otherwise the
+ * block is found by binary search over the first keys and scanned.
+ *
+ * The interface (count, size, empty) follows std::unordered_set, which was used before.
+ */
+class DeletedKeySet final {
+ public:
+  DeletedKeySet() : size_(0) {}
+
+  /**
+   * Create the set from a list of keys, the keys do not have to be sorted or unique.
+   */
+  explicit DeletedKeySet(std::vector<std::string> keys) : size_(0) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    Reserve(keys.size());
+    for (const std::string& key : keys) {
+      Append(key);
+    }
+    Finalize();
+  }
+
+  /**
+   * Create the set as union of an existing set and new keys.
+   */
+  DeletedKeySet(const DeletedKeySet& base, const std::unordered_set<std::string>& keys) : size_(0) {
+    std::vector<std::string> sorted_keys(keys.begin(), keys.end());
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+
+    Reserve(base.size() + sorted_keys.size());
+    auto keys_it = sorted_keys.cbegin();
+    base.ForEach([this, &keys_it, &sorted_keys](const std::string& key) {
+      while (keys_it != sorted_keys.cend() && *keys_it < key) {
+        Append(*keys_it++);
+      }
+      if (keys_it != sorted_keys.cend() && *keys_it == key) {
+        ++keys_it;
+      }
+      Append(key);
+    });
+
+    while (keys_it != sorted_keys.cend()) {
+      Append(*keys_it++);
+    }
+    Finalize();
+  }
+
+  DeletedKeySet& operator=(DeletedKeySet const&) = delete;
+  DeletedKeySet(const DeletedKeySet& that) = delete;
+
+  size_t count(const std::string& key) const {
+    if (size_ == 0 || !key_filter_->MayContain(key)) {
+      return 0;
+    }
+
+    // find the last block with a first key <= key
+    auto block_it = std::upper_bound(block_offsets_.cbegin(), block_offsets_.cend(), key,
+                                     [this](const std::string& k, const uint32_t offset) {
+                                       return Compare(k, FirstKeyOfBlock(offset)) < 0;
+                                     });
+    if (block_it == block_offsets_.cbegin()) {
+      return 0;
+    }
+
+    const size_t block = std::distance(block_offsets_.cbegin(), block_it) - 1;
+    const size_t block_end = block + 1 < block_offsets_.size() ? block_offsets_[block + 1] : keys_.size();
+
+    std::string current;
+    size_t offset = block_offsets_[block];
+    while (offset < block_end) {
+      offset = DecodeNext(offset, &current);
+      const int cmp = current.compare(key);
+      if (cmp == 0) {
+        return 1;
+      }
+      if (cmp > 0) {
+        break;
+      }
+    }
+    return 0;
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Call the given function for every key in sorted order.
+   */
+  template <typename FuncT>
+  void ForEach(FuncT func) const {
+    std::string current;
+    size_t offset = 0;
+    while (offset < keys_.size()) {
+      offset = DecodeNext(offset, &current);
+      func(current);
+    }
+  }
+
+  /**
+   * Memory usage in bytes, without the object itself.
+   */
+  size_t SizeInBytes() const {
+    return keys_.capacity() + block_offsets_.capacity() * sizeof(uint32_t) +
+           (key_filter_ ? key_filter_->SizeInBytes() : 0);
+  }
+
+ private:
+  static const size_t kBlockSize = 16;
+  static const size_t kKeyFilterBitsPerKey = 10;
+
+  size_t size_;
+  std::string keys_;
+  std::vector<uint32_t> block_offsets_;
+  std::string last_key_;
+  std::unique_ptr<dictionary::util::KeyFilter> key_filter_;
+
+  void Reserve(const size_t number_of_keys) {
+    block_offsets_.reserve((number_of_keys + kBlockSize - 1) / kBlockSize);
+    key_filter_.reset(new dictionary::util::KeyFilter(number_of_keys, kKeyFilterBitsPerKey));
+  }
+
+  /**
+   * Append a key, keys must be appended in sorted order and without duplicates.
+   */
+  void Append(const std::string& key) {
+    size_t shared_prefix = 0;
+    if (size_ % kBlockSize == 0) {
+      block_offsets_.push_back(keys_.size());
+    } else {
+      const size_t max_prefix = std::min(key.size(), last_key_.size());
+      while (shared_prefix < max_prefix && key[shared_prefix] == last_key_[shared_prefix]) {
+        ++shared_prefix;
+      }
+    }
+
+    size_t written_bytes = 0;
+    keyvi::util::encodeVarint(shared_prefix, &keys_, &written_bytes);
+    keyvi::util::encodeVarint(key.size() - shared_prefix, &keys_, &written_bytes);
+    keys_.append(key, shared_prefix, std::string::npos);
+
+    key_filter_->Add(key);
+    last_key_ = key;
+    ++size_;
+  }
+
+  void Finalize() {
+    keys_.shrink_to_fit();
+    last_key_.clear();
+    last_key_.shrink_to_fit();
+  }
+
+  /**
+   * Decode the key at the given offset, current must contain the previous key of the block, returns the offset of the
+   * next key.
+   */
+  size_t DecodeNext(size_t offset, std::string* current) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(keys_.data());
+    const size_t shared_prefix = keyvi::util::decodeVarint(data + offset);
+    offset += keyvi::util::getVarintLength(shared_prefix);
+    const size_t suffix_length = keyvi::util::decodeVarint(data + offset);
+    offset += keyvi::util::getVarintLength(suffix_length);
+
+    current->resize(shared_prefix);
+    current->append(keys_, offset, suffix_length);
+    return offset + suffix_length;
+  }
+
+  std::pair<const char*, size_t> FirstKeyOfBlock(size_t offset) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(keys_.data());
+    // skip the shared prefix, which is always 0 for the 1st key
+    offset += 1;
+    const size_t length = keyvi::util::decodeVarint(data + offset);
+    offset += keyvi::util::getVarintLength(length);
+    return std::make_pair(keys_.data() + offset, length);
+  }
+
+  static int Compare(const std::string& key, const std::pair<const char*, size_t>& other) {
+    const int cmp = std::memcmp(key.data(), other.first, std::min(key.size(), other.second));
+    if (cmp != 0) {
+      return cmp;
+    }
+    return key.size() < other.second ? -1 : (key.size() > other.second ? 1 : 0);
+  }
+};
+
+/**
+ * Deleted keys of a segment: a shared, immutable base plus the keys deleted since.
+ *
+ * The base is shared between the readers and the writer of the segment (copy-on-write), new deletes go into a small
+ * overlay which gets folded into a new base once it outgrows the base. Copying is cheap as long as the overlay is
+ * small, readers create a new copy for every change and swap it in.
+ */
+class DeletedKeysOverlay final {
+ public:
+  DeletedKeysOverlay() : base_(std::make_shared<DeletedKeySet>()), overlay_() {}
+
+  void Reset(const std::shared_ptr<const DeletedKeySet>& base) {
+    base_ = base ? base : std::make_shared<DeletedKeySet>();
+    overlay_.clear();
+  }
+
+  /**
+   * Insert a key, returns false if the key is already in the set.
+   */
+  bool Insert(const std::string& key) { return base_->count(key) == 0 && overlay_.insert(key).second; }
+
+  void Insert(const DeletedKeysOverlay& other) {
+    other.ForEach([this](const std::string& key) { Insert(key); });
+  }
+
+  size_t count(const std::string& key) const { return overlay_.count(key) + base_->count(key); }
+
+  size_t size() const { return base_->size() + overlay_.size(); }
+
+  void clear() { Reset(std::shared_ptr<const DeletedKeySet>()); }
+
+  /**
+   * Call the given function for every key, keys of the base come first in sorted order.
+   */
+  template <typename FuncT>
+  void ForEach(FuncT func) const {
+    base_->ForEach(func);
+    for (const std::string& key : overlay_) {
+      func(key);
+    }
+  }
+
+  /**
+   * Whether the overlay has outgrown the base, compacting at that point keeps the cost amortized linear.
+   */
+  bool NeedsCompaction() const { return overlay_.size() >= kMinKeysForCompaction && overlay_.size() >= base_->size(); }
+
+  /**
+   * Fold the overlay into a new base and return it.
+   */
+  const std::shared_ptr<const DeletedKeySet>& Compact() {
+    if (!overlay_.empty()) {
+      base_ = std::make_shared<DeletedKeySet>(*base_, overlay_);
+      overlay_.clear();
+    }
+    return base_;
+  }
+
+ private:
+  static const size_t kMinKeysForCompaction = 1024;
+
+  std::shared_ptr<const DeletedKeySet> base_;
+  std::unordered_set<std::string> overlay_;
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
@@ -0,0 +1,140 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * deleted_keys_journal.h
+ *
+ *  Created on: Jul 14, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_DELETED_KEYS_JOURNAL_H_
+#define KEYVI_INDEX_INTERNAL_DELETED_KEYS_JOURNAL_H_
+
+#include <chrono>  //NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <msgpack.hpp>
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Append-only journal of deleted keys, stored next to the file with the full list of deleted keys (.dk -> .dkl,
+ * .dkm -> .dkml).
+ *
+ * The journal is a stream of msgpack objects: a header with the epoch followed by one string per deleted key. When
+ * the journal gets compacted into the full list, it is replaced by an empty journal with a new epoch. Readers tail
+ * the journal from the last offset as long as the epoch does not change, a new epoch tells them to reload the full
+ * list. The new full list is always in place before the journal with the new epoch, so a reader that sees a new
+ * epoch is guaranteed to load a full list that contains the keys of the old journal.
+ */
+class DeletedKeysJournal final {
+ public:
+  static std::string JournalFilename(const std::string& deleted_keys_filename) { return deleted_keys_filename + "l"; }
+
+  /**
+   * Create a new, empty journal with a new epoch, replaces an existing journal atomically.
+   */
+  static void Create(const std::string& filename) {
+    const std::string swap_filename = filename + "-swap";
+    {
+      std::ofstream out_stream(swap_filename, std::ios::binary);
+      msgpack::pack(out_stream, NewEpoch());
+    }
+    std::rename(swap_filename.c_str(), filename.c_str());
+  }
+
+  /**
+   * Append keys to the journal, the journal gets created if it does not exist.
+   */
+  static void Append(const std::string& filename, const std::vector<std::string>& keys) {
+    if (!std::ifstream(filename).good()) {
+      Create(filename);
+    }
+
+    std::ofstream out_stream(filename, std::ios::binary | std::ios::app);
+    for (const std::string& key : keys) {
+      msgpack::pack(out_stream, key);
+    }
+  }
+
+  /**
+   * Read new keys from the journal.
+   *
+   * @param filename the journal
+   * @param epoch the epoch of the last read, 0 if unknown; updated to the epoch of the journal
+   * @param offset the offset after the last read key; updated to the offset after the last complete key
+   * @param keys new keys get appended to keys, all keys if the epoch has changed
+   * @return false if the journal does not exist
+   */
+  static bool Tail(const std::string& filename, uint64_t* epoch, size_t* offset, std::vector<std::string>* keys) {
+    std::ifstream in_stream(filename, std::ios::binary);
+    if (!in_stream.good()) {
+      return false;
+    }
+
+    const std::string buffer((std::istreambuf_iterator<char>(in_stream)), std::istreambuf_iterator<char>());
+    size_t position = 0;
+    msgpack::object_handle unpacked_object;
+
+    try {
+      msgpack::unpack(unpacked_object, buffer.data(), buffer.size(), position);
+      const uint64_t journal_epoch = unpacked_object.get().as<uint64_t>();
+      if (journal_epoch != *epoch || *offset < position || *offset > buffer.size()) {
+        TRACE("new journal epoch, read from start");
+        *epoch = journal_epoch;
+      } else {
+        position = *offset;
+      }
+
+      while (position < buffer.size()) {
+        size_t next_position = position;
+        msgpack::unpack(unpacked_object, buffer.data(), buffer.size(), next_position);
+        keys->push_back(unpacked_object.get().as<std::string>());
+        position = next_position;
+      }
+    } catch (msgpack::insufficient_bytes&) {
+      // the writer is in the middle of appending, the incomplete key will be read next time
+      TRACE("incomplete journal entry at %ld", position);
+    }
+
+    *offset = position;
+    return true;
+  }
+
+ private:
+  static uint64_t NewEpoch() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_DELETED_KEYS_JOURNAL_H_
@@ -24,11 +24,14 @@
 
 #include <map>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "keyvi/dictionary/fsa/automata.h"
 #include "keyvi/dictionary/match.h"
+#include "keyvi/index/internal/deleted_key_set.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -37,6 +40,33 @@ namespace keyvi {
 namespace index {
 namespace internal {
 
+/**
+ * The keys to drop from the matches of a segment: its own deleted keys and the tombstones of all newer segments.
+ */
+template <class DeletedPtrT>
+class SegmentDeletedKeys final {
+ public:
+  SegmentDeletedKeys(const DeletedPtrT& deleted_keys,
+                     const std::vector<std::shared_ptr<const DeletedKeySet>>& newer_tombstones)
+      : deleted_keys_(deleted_keys), newer_tombstones_(newer_tombstones) {}
+
+  size_t count(const std::string& key) const {
+    if (deleted_keys_ && deleted_keys_->count(key) > 0) {
+      return 1;
+    }
+    for (const auto& tombstones : newer_tombstones_) {
+      if (tombstones->count(key) > 0) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+ private:
+  DeletedPtrT deleted_keys_;
+  std::vector<std::shared_ptr<const DeletedKeySet>> newer_tombstones_;
+};
+
 /**
  * Filters matches and drops results for deleted keys for a single FSA.
  */
@@ -110,26 +140,40 @@ inline keyvi::dictionary::Match FirstFilteredMatch(const MatcherT& matcher, cons
   return first_match;
 }
 
+/**
+ * Collect the keys to drop per FSA, FSA's without deleted keys and without newer tombstones are not in the map.
+ *
+ * All segments have to be checked for tombstones, also the ones that have been filtered out by the matcher.
+ */
 template <class SegmentT, class StatePairT>
-inline std::map<dictionary::fsa::automata_t, typename SegmentT::deleted_ptr_t> CreatedDeletedKeysMap(
-    const std::shared_ptr<std::vector<std::shared_ptr<SegmentT>>>& segments,
-    const std::vector<StatePairT>& fsa_start_state_pairs) {
-  std::map<dictionary::fsa::automata_t, typename SegmentT::deleted_ptr_t> deleted_keys_map;
-
-  auto segments_it = segments->cbegin();
-  for (const auto& fsa : fsa_start_state_pairs) {
-    while (std::get<0>(fsa) != (*segments_it)->GetDictionary()->GetFsa()) {
-      ++segments_it;
-      // this should never happen
-      if (segments_it == segments->end()) {
-        throw std::runtime_error("order of segments do not match expected order");
+inline std::map<dictionary::fsa::automata_t,
+                std::shared_ptr<const SegmentDeletedKeys<typename SegmentT::deleted_ptr_t>>>
+CreatedDeletedKeysMap(const std::shared_ptr<std::vector<std::shared_ptr<SegmentT>>>& segments,
+                      const std::vector<StatePairT>& fsa_start_state_pairs) {
+  using segment_deleted_keys_t = SegmentDeletedKeys<typename SegmentT::deleted_ptr_t>;
+  std::map<dictionary::fsa::automata_t, std::shared_ptr<const segment_deleted_keys_t>> deleted_keys_map;
+  std::vector<std::shared_ptr<const DeletedKeySet>> newer_tombstones;
+
+  // walk newest first to collect the tombstones of newer segments on the way
+  auto fsa_it = fsa_start_state_pairs.crbegin();
+  for (auto segments_it = segments->crbegin(); segments_it != segments->crend(); ++segments_it) {
+    if (fsa_it != fsa_start_state_pairs.crend() && std::get<0>(*fsa_it) == (*segments_it)->GetDictionary()->GetFsa()) {
+      TRACE("found corresponding sement");
+      if ((*segments_it)->DeletedKeysSize() > 0 || !newer_tombstones.empty()) {
+        deleted_keys_map.emplace(std::get<0>(*fsa_it), std::make_shared<segment_deleted_keys_t>(
+                                                           (*segments_it)->DeletedKeys(), newer_tombstones));
       }
+      ++fsa_it;
     }
-    TRACE("found corresponding sement");
-    if ((*segments_it)->DeletedKeysSize() > 0) {
-      deleted_keys_map.emplace(std::get<0>(fsa), (*segments_it)->DeletedKeys());
+
+    if ((*segments_it)->Tombstones()) {
+      newer_tombstones.push_back((*segments_it)->Tombstones());
     }
-    ++segments_it;
+  }
+
+  // this should never happen
+  if (fsa_it != fsa_start_state_pairs.crend()) {
+    throw std::runtime_error("order of segments do not match expected order");
   }
 
   return deleted_keys_map;
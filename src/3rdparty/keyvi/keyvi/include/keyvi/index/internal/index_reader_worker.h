@@ -48,6 +48,7 @@
 #include "keyvi/dictionary/match.h"
 #include "keyvi/index/constants.h"
 #include "keyvi/index/internal/read_only_segment.h"
+#include "keyvi/index/internal/value_cache.h"
 #include "keyvi/util/configuration.h"
 
 // #define ENABLE_TRACING
@@ -63,9 +64,15 @@ class IndexReaderWorker final {
       : segments_(),
         refresh_interval_(
             std::chrono::milliseconds(keyvi::util::mapGet<uint64_t>(params, INDEX_REFRESH_INTERVAL, 1000))),
-        stop_update_thread_(true) {
+        stop_update_thread_(true),
+        value_cache_() {
     index_directory_ = index_directory;
 
+    const size_t value_cache_size = keyvi::util::mapGet<size_t>(params, VALUE_CACHE_SIZE, DEFAULT_VALUE_CACHE_SIZE);
+    if (value_cache_size > 0) {
+      value_cache_.reset(new ValueCache(value_cache_size));
+    }
+
     index_toc_file_ = index_directory_;
     index_toc_file_ /= "index.toc";
 
@@ -100,10 +107,16 @@ class IndexReaderWorker final {
   }
 
   void Reload() {
-    ReloadIndex();
-    ReloadDeletedKeys();
+    const bool index_changed = ReloadIndex();
+    const bool deleted_keys_changed = ReloadDeletedKeys();
+    ClearValueCacheIfChanged(index_changed || deleted_keys_changed);
   }
 
+  /**
+   * Get the value cache, nullptr if disabled.
+   */
+  ValueCache* GetValueCache() { return value_cache_.get(); }
+
   const_read_only_segments_t Segments() {
     read_only_segments_t segments = segments_weak_.lock();
     if (!segments) {
@@ -125,20 +138,24 @@ class IndexReaderWorker final {
   std::chrono::milliseconds refresh_interval_;
   std::thread update_thread_;
   std::atomic_bool stop_update_thread_;
+  std::unique_ptr<ValueCache> value_cache_;
 
-  void ReloadIndex() {
+  /**
+   * Reload the index toc, returns true if the segments have changed.
+   */
+  bool ReloadIndex() {
     std::time_t t = boost::filesystem::last_write_time(index_toc_file_);
 
     if (t <= last_modification_time_) {
       TRACE("no modifications found");
-      return;
+      return false;
     }
 
     TRACE("reload toc");
     last_modification_time_ = t;
     if (!boost::filesystem::exists(index_directory_)) {
       TRACE("No index found.");
-      return;
+      return false;
     }
     std::ifstream toc_fstream(index_toc_file_.string());
     TRACE("rereading %s", index_toc_file_.string().c_str());
@@ -178,13 +195,32 @@ class IndexReaderWorker final {
       segments_.swap(new_segments);
     }
 
+    // reset as segments have been changed
+    segments_weak_.reset();
+
     segments_by_name_.swap(new_segments_by_name);
     TRACE("Loaded new segments");
+    return true;
   }
 
-  void ReloadDeletedKeys() {
+  /**
+   * Reload deleted keys of all segments, returns true if any segment has new deletes.
+   */
+  bool ReloadDeletedKeys() {
+    bool changed = false;
     for (const read_only_segment_t& s : *segments_) {
-      s->ReloadDeletedKeys();
+      changed |= s->ReloadDeletedKeys();
+    }
+    return changed;
+  }
+
+  /**
+   * The reader does not know which keys have changed, so the whole cache gets dropped. Must be called after the
+   * change became visible.
+   */
+  void ClearValueCacheIfChanged(const bool changed) {
+    if (changed && value_cache_) {
+      value_cache_->Clear();
     }
   }
 
@@ -192,8 +228,9 @@ class IndexReaderWorker final {
     while (!stop_update_thread_) {
       TRACE("UpdateWatcher: Check for new segments");
       // reload
-      ReloadIndex();
-      ReloadDeletedKeys();
+      const bool index_changed = ReloadIndex();
+      const bool deleted_keys_changed = ReloadDeletedKeys();
+      ClearValueCacheIfChanged(index_changed || deleted_keys_changed);
       // sleep for next refresh
       std::this_thread::sleep_for(refresh_interval_);
     }
@@ -24,11 +24,14 @@
 #ifndef KEYVI_INDEX_INTERNAL_INDEX_SETTINGS_H_
 #define KEYVI_INDEX_INTERNAL_INDEX_SETTINGS_H_
 
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 
 #include <boost/variant.hpp>
 
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/fsa/internal/value_store_types.h"
 #include "keyvi/index/constants.h"
 #include "keyvi/index/internal/index_auto_config.h"
 #include "keyvi/util/configuration.h"
@@ -47,7 +50,7 @@ class IndexSettings final {
     if (params.count(KEYVIMERGER_BIN)) {
       settings_[KEYVIMERGER_BIN] = params.at(KEYVIMERGER_BIN);
     } else {
-      settings_[KEYVIMERGER_BIN] = DEFAULT_KEYVIMERGER_BIN;
+      settings_[KEYVIMERGER_BIN] = std::string(DEFAULT_KEYVIMERGER_BIN);
     }
     if (params.count(INDEX_MAX_SEGMENTS)) {
       settings_[INDEX_MAX_SEGMENTS] = keyvi::util::mapGet<size_t>(params, INDEX_MAX_SEGMENTS);
@@ -59,6 +62,13 @@ class IndexSettings final {
     } else {
       settings_[MAX_CONCURRENT_MERGES] = IndexAutoConfig::MaxConcurrentMerges();
     }
+    if (params.count(MAX_CONCURRENT_COMPILES)) {
+      // at least 1, compiles always run in the background
+      const size_t max_concurrent_compiles = keyvi::util::mapGet<size_t>(params, MAX_CONCURRENT_COMPILES);
+      settings_[MAX_CONCURRENT_COMPILES] = max_concurrent_compiles > 0 ? max_concurrent_compiles : 1;
+    } else {
+      settings_[MAX_CONCURRENT_COMPILES] = DEFAULT_MAX_CONCURRENT_COMPILES;
+    }
     if (params.count(SEGMENT_COMPILE_KEY_THRESHOLD)) {
       settings_[SEGMENT_COMPILE_KEY_THRESHOLD] = keyvi::util::mapGet<size_t>(params, SEGMENT_COMPILE_KEY_THRESHOLD);
     } else {
@@ -75,6 +85,24 @@ class IndexSettings final {
     } else {
       settings_[SEGMENT_EXTERNAL_MERGE_KEY_THRESHOLD] = DEFAULT_EXTERNAL_MERGE_KEY_THRESHOLD;
     }
+    if (params.count(VALUE_CACHE_SIZE)) {
+      settings_[VALUE_CACHE_SIZE] = keyvi::util::mapGet<size_t>(params, VALUE_CACHE_SIZE);
+    } else {
+      settings_[VALUE_CACHE_SIZE] = DEFAULT_VALUE_CACHE_SIZE;
+    }
+    if (params.count(KEY_FILTER_BITS_PER_KEY)) {
+      settings_[KEY_FILTER_BITS_PER_KEY] = keyvi::util::mapGet<size_t>(params, KEY_FILTER_BITS_PER_KEY);
+    } else {
+      settings_[KEY_FILTER_BITS_PER_KEY] = DEFAULT_INDEX_KEY_FILTER_BITS_PER_KEY;
+    }
+    settings_[TOMBSTONES_KEY] = keyvi::util::mapGetBool(params, TOMBSTONES_KEY, DEFAULT_INDEX_TOMBSTONES);
+    if (params.count(VALUE_STORE_TYPE)) {
+      // fail early on unknown types
+      ParseValueStoreType(params.at(VALUE_STORE_TYPE));
+      settings_[VALUE_STORE_TYPE] = params.at(VALUE_STORE_TYPE);
+    } else {
+      settings_[VALUE_STORE_TYPE] = std::string(DEFAULT_VALUE_STORE_TYPE);
+    }
   }
 
   const std::string& GetKeyviMergerBin() const { return boost::get<std::string>(settings_.at(KEYVIMERGER_BIN)); }
@@ -87,14 +115,43 @@ class IndexSettings final {
 
   const size_t GetMaxConcurrentMerges() const { return boost::get<size_t>(settings_.at(MAX_CONCURRENT_MERGES)); }
 
+  const size_t GetMaxConcurrentCompiles() const {
+    return boost::get<size_t>(settings_.at(MAX_CONCURRENT_COMPILES));
+  }
+
   const size_t GetRefreshInterval() const { return boost::get<size_t>(settings_.at(INDEX_REFRESH_INTERVAL)); }
 
   const size_t GetSegmentExternalMergeKeyThreshold() const {
     return boost::get<size_t>(settings_.at(SEGMENT_EXTERNAL_MERGE_KEY_THRESHOLD));
   }
 
+  const size_t GetValueCacheSize() const { return boost::get<size_t>(settings_.at(VALUE_CACHE_SIZE)); }
+
+  const size_t GetKeyFilterBitsPerKey() const { return boost::get<size_t>(settings_.at(KEY_FILTER_BITS_PER_KEY)); }
+
+  const bool GetTombstones() const { return boost::get<bool>(settings_.at(TOMBSTONES_KEY)); }
+
+  const std::string& GetValueStoreTypeName() const { return boost::get<std::string>(settings_.at(VALUE_STORE_TYPE)); }
+
+  const dictionary::fsa::internal::value_store_t GetValueStoreType() const {
+    return ParseValueStoreType(GetValueStoreTypeName());
+  }
+
+  static dictionary::fsa::internal::value_store_t ParseValueStoreType(const std::string& name) {
+    if (name == "json") {
+      return dictionary::fsa::internal::value_store_t::JSON;
+    } else if (name == "string") {
+      return dictionary::fsa::internal::value_store_t::STRING;
+    } else if (name == "int") {
+      return dictionary::fsa::internal::value_store_t::INT;
+    } else if (name == "key_only") {
+      return dictionary::fsa::internal::value_store_t::KEY_ONLY;
+    }
+    throw std::invalid_argument("unknown value store type: " + name);
+  }
+
  private:
-  std::unordered_map<std::string, boost::variant<std::string, size_t>> settings_;
+  std::unordered_map<std::string, boost::variant<std::string, size_t, bool>> settings_;
 };
 
 } /* namespace internal */
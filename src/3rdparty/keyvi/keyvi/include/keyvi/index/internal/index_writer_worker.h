@@ -35,6 +35,7 @@
 #include <list>
 #include <memory>
 #include <mutex>  //NOLINT
+#include <stdexcept>
 #include <string>
 #include <thread>  //NOLINT
 #include <utility>
@@ -48,13 +49,16 @@
 #include "rapidjson/ostreamwrapper.h"
 #include "rapidjson/writer.h"
 
-#include "keyvi/dictionary/dictionary_index_compiler.h"
-#include "keyvi/dictionary/dictionary_types.h"
+#include "keyvi/dictionary/fsa/internal/json_value_store.h"
 #include "keyvi/index/constants.h"
+#include "keyvi/index/internal/compile_job.h"
 #include "keyvi/index/internal/index_settings.h"
 #include "keyvi/index/internal/merge_job.h"
 #include "keyvi/index/internal/merge_policy_selector.h"
 #include "keyvi/index/internal/segment.h"
+#include "keyvi/index/internal/segment_compiler.h"
+#include "keyvi/index/internal/value_cache.h"
+#include "keyvi/index/internal/write_batch.h"
 #include "keyvi/index/types.h"
 #include "keyvi/util/active_object.h"
 #include "keyvi/util/configuration.h"
@@ -67,43 +71,77 @@ namespace index {
 namespace internal {
 
 class IndexWriterWorker final {
-  using compiler_t = std::shared_ptr<dictionary::JsonDictionaryIndexCompiler>;
+  using compiler_t = std::shared_ptr<SegmentCompilerInterface>;
+  using value_encoder_t = std::unique_ptr<dictionary::fsa::internal::JsonValueEncoder>;
+  using encoded_value_t = dictionary::fsa::internal::EncodedJsonValue;
   struct IndexPayload {
     explicit IndexPayload(const std::string& index_directory, const keyvi::util::parameters_t& params)
         : compiler_(),
           write_counter_(0),
           segments_(),
+          generation_(0),
           mutex_(),
           index_directory_(index_directory),
           index_toc_file_(index_directory_ / "index.toc"),
           index_toc_file_part_(index_directory_ / "index.toc.part"),
           settings_(params),
+          value_store_type_(settings_.GetValueStoreType()),
           max_concurrent_merges_(settings_.GetMaxConcurrentMerges()),
+          max_concurrent_compiles_(settings_.GetMaxConcurrentCompiles()),
           max_segments_(settings_.GetMaxSegments()),
           compile_key_threshold_(settings_.GetSegmentCompileKeyThreshold()),
           index_refresh_interval_(settings_.GetRefreshInterval()),
           merge_jobs_(),
+          compile_jobs_(),
+          compile_job_done_(),
           any_delete_(false),
-          merge_enabled_(true) {
+          merge_enabled_(true),
+          value_cache_(),
+          value_cache_written_keys_(),
+          value_cache_deleted_keys_(),
+          write_batch_mutex_(),
+          write_batch_(),
+          value_encoders_mutex_(),
+          value_encoders_() {
       segments_ = std::make_shared<segment_vec_t>();
+      if (settings_.GetValueCacheSize() > 0) {
+        value_cache_.reset(new ValueCache(settings_.GetValueCacheSize()));
+      }
     }
 
     compiler_t compiler_;
     std::atomic_size_t write_counter_;
     segments_t segments_;
     std::weak_ptr<segment_vec_t> segments_weak_;
+    std::atomic_size_t generation_;
     std::mutex mutex_;
     const boost::filesystem::path index_directory_;
     const boost::filesystem::path index_toc_file_;
     const boost::filesystem::path index_toc_file_part_;
     const internal::IndexSettings settings_;
+    const dictionary::fsa::internal::value_store_t value_store_type_;
     const size_t max_concurrent_merges_;
+    const size_t max_concurrent_compiles_;
     const size_t max_segments_;
     const size_t compile_key_threshold_;
     const size_t index_refresh_interval_;
     std::list<MergeJob> merge_jobs_;
+    // segments being compiled, oldest first, published in this order
+    std::list<CompileJob> compile_jobs_;
+    // called from the compile thread when a job is done
+    std::function<void()> compile_job_done_;
     bool any_delete_;
     std::atomic_bool merge_enabled_;
+    std::unique_ptr<ValueCache> value_cache_;
+    // keys to invalidate in the value cache once the change becomes visible
+    std::vector<std::string> value_cache_written_keys_;
+    std::vector<std::string> value_cache_deleted_keys_;
+    // the batch single key writes get appended to, already scheduled for the writer thread
+    std::mutex write_batch_mutex_;
+    std::shared_ptr<WriteBatch> write_batch_;
+    // idle value encoders, values get encoded on the caller thread before they are handed to the writer thread
+    std::mutex value_encoders_mutex_;
+    std::vector<value_encoder_t> value_encoders_;
   };
 
  public:
@@ -113,6 +151,11 @@ class IndexWriterWorker final {
         compiler_active_object_(&payload_, std::bind(&index::internal::IndexWriterWorker::ScheduledTask, this),
                                 std::chrono::milliseconds(payload_.index_refresh_interval_)) {
     TRACE("construct worker: %s", payload_.index_directory_.c_str());
+
+    // publish from the writer thread, the callback is invoked before the job gets joined, so the writer is still alive
+    payload_.compile_job_done_ = [this]() {
+      compiler_active_object_([](IndexPayload& payload) { PublishCompiledSegments(&payload); });
+    };
     LoadIndex();
   }
 
@@ -123,9 +166,10 @@ class IndexWriterWorker final {
     TRACE("destruct worker: %s", payload_.index_directory_.c_str());
     payload_.merge_enabled_ = false;
 
-    // push a function to finish all pending merges
-    compiler_active_object_([](IndexPayload& payload) {
+    // push a function to finish all pending compiles and merges
+    Schedule([](IndexPayload& payload) {
       Compile(&payload);
+      WaitForCompileJobs(&payload);
       for (MergeJob& p : payload.merge_jobs_) {
         p.Finalize();
       }
@@ -143,17 +187,38 @@ class IndexWriterWorker final {
     return segments;
   }
 
-  // todo: rvalue version??
+  /**
+   * Get the generation of the segments, the generation changes whenever new data becomes visible to readers,
+   * either by swapping the segments or by persisting deletes.
+   *
+   * Read the generation before reading the segments, this way the segments are at least as new as the generation.
+   */
+  size_t Generation() const { return payload_.generation_.load(); }
+
+  /**
+   * Get the value cache, nullptr if disabled.
+   */
+  ValueCache* GetValueCache() { return payload_.value_cache_.get(); }
+
   void Add(const std::string& key, const std::string& value) {
-    // push function
     TRACE("add key %s, pt: %p", key.c_str(), &key);
 
-    // strings are copied
-    compiler_active_object_([key, value](IndexPayload& payload) {
-      CreateCompilerIfNeeded(&payload);
-      TRACE("add_async key %s, pt: %p", key.c_str(), &key);
-      payload.compiler_->Add(key, value);
-    });
+    if (payload_.value_store_type_ != dictionary::fsa::internal::value_store_t::JSON) {
+      CheckValue(value);
+
+      // strings are copied into the write batch
+      std::lock_guard<std::mutex> lock(payload_.write_batch_mutex_);
+      CurrentWriteBatch()->Set(key, value);
+    } else {
+      encoded_value_t encoded_value;
+      WithValueEncoder([&value, &encoded_value](dictionary::fsa::internal::JsonValueEncoder* encoder) {
+        encoder->Encode(value, &encoded_value);
+      });
+
+      // strings are copied into the write batch
+      std::lock_guard<std::mutex> lock(payload_.write_batch_mutex_);
+      CurrentWriteBatch()->SetEncoded(key, encoded_value.value_, encoded_value.hashcode_);
+    }
 
     CompileIfThresholdIsHit();
   }
@@ -162,32 +227,98 @@ class IndexWriterWorker final {
   void Add(const std::shared_ptr<ContainerType>& key_values) {
     TRACE("bulk add keys: %ul", key_values->size());
 
-    // the shared pointer is copied (not the key/values)
-    compiler_active_object_([key_values](IndexPayload& payload) {
-      CreateCompilerIfNeeded(&payload);
+    if (payload_.value_store_type_ != dictionary::fsa::internal::value_store_t::JSON) {
+      for (const auto& key_value : *key_values) {
+        CheckValue(key_value.second);
+      }
 
-      for (auto key_value : *key_values) {
+      // the shared pointer is copied (not the key/values)
+      Schedule([key_values](IndexPayload& payload) {
+        for (const auto& key_value : *key_values) {
+          AddKey(&payload, key_value.first, key_value.second);
+        }
+      });
+      CompileIfThresholdIsHit();
+      return;
+    }
+
+    // values are encoded on the caller thread, in the order of the keys
+    std::shared_ptr<std::vector<encoded_value_t>> encoded_values = std::make_shared<std::vector<encoded_value_t>>();
+    encoded_values->reserve(key_values->size());
+    WithValueEncoder([&key_values, &encoded_values](dictionary::fsa::internal::JsonValueEncoder* encoder) {
+      for (const auto& key_value : *key_values) {
+        encoded_values->emplace_back();
+        encoder->Encode(key_value.second, &encoded_values->back());
+      }
+    });
+
+    // the shared pointers are copied (not the key/values)
+    Schedule([key_values, encoded_values](IndexPayload& payload) {
+      auto encoded_value_it = encoded_values->cbegin();
+      for (const auto& key_value : *key_values) {
         TRACE("add_async key %s, pt: %p", key_value.first.c_str(), &key_value.first);
-        payload.compiler_->Add(key_value.first, key_value.second);
+        AddEncodedKey(&payload, key_value.first, *encoded_value_it++);
       }
     });
     CompileIfThresholdIsHit();
   }
 
   void Delete(const std::string& key) {
-    compiler_active_object_([key](IndexPayload& payload) {
+    TRACE("delete key %s", key.c_str());
+
+    {
+      std::lock_guard<std::mutex> lock(payload_.write_batch_mutex_);
+      CurrentWriteBatch()->Delete(key);
+    }
+
+    CompileIfThresholdIsHit();
+  }
+
+  /**
+   * Delete multiple keys with one queue item, the keys are sorted once and every segment is checked with a single
+   * co-traversal of its FSA.
+   */
+  template <typename ContainerType>
+  void Delete(const std::shared_ptr<ContainerType>& keys) {
+    TRACE("bulk delete keys: %ul", keys->size());
+
+    // the shared pointer is copied (not the keys)
+    Schedule([keys](IndexPayload& payload) {
+      if (payload.settings_.GetTombstones()) {
+        for (const std::string& key : *keys) {
+          AddTombstone(&payload, key);
+        }
+        return;
+      }
+
       payload.any_delete_ = true;
-      TRACE("delete key %s", key.c_str());
+
+      std::vector<std::string> sorted_keys(keys->begin(), keys->end());
+      std::sort(sorted_keys.begin(), sorted_keys.end());
+      sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()), sorted_keys.end());
 
       if (payload.compiler_) {
-        payload.compiler_->Delete(key);
+        for (const std::string& key : sorted_keys) {
+          payload.compiler_->Delete(key);
+        }
+      }
+
+      for (CompileJob& compile_job : payload.compile_jobs_) {
+        for (const std::string& key : sorted_keys) {
+          compile_job.DeleteKey(key);
+        }
       }
 
       if (payload.segments_) {
         for (const segment_t& s : *payload.segments_) {
-          s->DeleteKey(key);
+          s->DeleteKeys(sorted_keys);
         }
       }
+
+      if (payload.value_cache_) {
+        payload.value_cache_deleted_keys_.insert(payload.value_cache_deleted_keys_.end(), sorted_keys.begin(),
+                                                 sorted_keys.end());
+      }
     });
 
     CompileIfThresholdIsHit();
@@ -200,7 +331,7 @@ class IndexWriterWorker final {
     TRACE("flush");
 
     if (async) {
-      compiler_active_object_([](IndexPayload& payload) {
+      Schedule([](IndexPayload& payload) {
         PersistDeletes(&payload);
         Compile(&payload);
       });
@@ -209,9 +340,10 @@ class IndexWriterWorker final {
       std::condition_variable c;
       std::unique_lock<std::mutex> lock(m);
 
-      compiler_active_object_([&m, &c](IndexPayload& payload) {
+      Schedule([&m, &c](IndexPayload& payload) {
         PersistDeletes(&payload);
         Compile(&payload);
+        WaitForCompileJobs(&payload);
         std::unique_lock<std::mutex> waitLock(m);
         c.notify_all();
       });
@@ -246,9 +378,78 @@ class IndexWriterWorker final {
   merge_policy_t merge_policy_;
   util::ActiveObject<IndexPayload> compiler_active_object_;
 
+  /**
+   * Push a function to the writer thread, all other writes must be scheduled with it to keep the order of writes.
+   *
+   * The open write batch gets closed, so single key writes after this call end up in a new batch behind it.
+   */
+  template <typename F>
+  void Schedule(F f) {
+    std::lock_guard<std::mutex> lock(payload_.write_batch_mutex_);
+    payload_.write_batch_.reset();
+    compiler_active_object_(f);
+  }
+
+  /**
+   * Reject values the value store can not take, on the caller thread as the writer thread can not report errors.
+   */
+  void CheckValue(const std::string& value) const {
+    if (!SegmentCompilerInterface::IsValidValue(payload_.value_store_type_, value)) {
+      throw std::invalid_argument("invalid value for value store type " + payload_.settings_.GetValueStoreTypeName() +
+                                  ": " + value);
+    }
+  }
+
+  /**
+   * Call the given function with an encoder for values, encoders are pooled as they are expensive to create and must
+   * not be used by 2 threads at the same time.
+   */
+  template <typename FuncT>
+  void WithValueEncoder(FuncT func) {
+    value_encoder_t encoder;
+    {
+      std::lock_guard<std::mutex> lock(payload_.value_encoders_mutex_);
+      if (!payload_.value_encoders_.empty()) {
+        encoder = std::move(payload_.value_encoders_.back());
+        payload_.value_encoders_.pop_back();
+      }
+    }
+
+    if (!encoder) {
+      encoder.reset(new dictionary::fsa::internal::JsonValueEncoder(CompilerParams(payload_.settings_)));
+    }
+
+    func(encoder.get());
+
+    std::lock_guard<std::mutex> lock(payload_.value_encoders_mutex_);
+    payload_.value_encoders_.push_back(std::move(encoder));
+  }
+
+  /**
+   * Get the open write batch, a new batch gets scheduled if there is none, must be called with the lock held.
+   */
+  WriteBatch* CurrentWriteBatch() {
+    if (!payload_.write_batch_) {
+      std::shared_ptr<WriteBatch> write_batch = std::make_shared<WriteBatch>();
+      payload_.write_batch_ = write_batch;
+
+      compiler_active_object_([write_batch](IndexPayload& payload) {
+        // close the batch, so it can be read without the lock
+        {
+          std::lock_guard<std::mutex> lock(payload.write_batch_mutex_);
+          if (payload.write_batch_ == write_batch) {
+            payload.write_batch_.reset();
+          }
+        }
+        ApplyWriteBatch(&payload, *write_batch);
+      });
+    }
+    return payload_.write_batch_.get();
+  }
+
   void CompileIfThresholdIsHit() {
     if (++payload_.write_counter_ > payload_.compile_key_threshold_) {
-      compiler_active_object_([](IndexPayload& payload) { Compile(&payload); });
+      Schedule([](IndexPayload& payload) { Compile(&payload); });
       payload_.write_counter_ = 0;
 
       // worst case scenario, to many segments, throttle further writes until we are below the limit
@@ -271,6 +472,8 @@ class IndexWriterWorker final {
       RunMerge();
     }
 
+    PublishCompiledSegments(&payload_);
+
     if (!payload_.compiler_ && !payload_.any_delete_) {
       return;
     }
@@ -326,6 +529,7 @@ class IndexWriterWorker final {
 
           // reset as segments have been changed
           payload_.segments_weak_.reset();
+          ++payload_.generation_;
 
           // delete old segment files
           for (const segment_t& s : p.Segments()) {
@@ -387,7 +591,10 @@ class IndexWriterWorker final {
       s->ElectedForMerge();
     }
 
-    payload_.merge_jobs_.emplace_back(to_merge, merge_policy_id, p, payload_.settings_);
+    // nothing is older than the merged segment, so its tombstones have nothing left to hide
+    const bool drop_tombstones = to_merge.front() == payload_.segments_->front();
+
+    payload_.merge_jobs_.emplace_back(to_merge, merge_policy_id, p, payload_.settings_, drop_tombstones);
 
     // force external merge if low on filedescriptors
     payload_.merge_jobs_.back().Run(payload_.segments_->size() + to_merge.size() + 10 > payload_.max_segments_);
@@ -407,6 +614,15 @@ class IndexWriterWorker final {
 
     TRACE("index_toc loaded");
 
+    // indexes without the type have been written before it became configurable
+    const std::string value_store_type = index_toc.HasMember(VALUE_STORE_TYPE)
+                                             ? index_toc[VALUE_STORE_TYPE].GetString()
+                                             : std::string(DEFAULT_VALUE_STORE_TYPE);
+    if (value_store_type != payload_.settings_.GetValueStoreTypeName()) {
+      throw std::invalid_argument("index has value store type " + value_store_type + ", configured is " +
+                                  payload_.settings_.GetValueStoreTypeName());
+    }
+
     TRACE("reading segments");
 
     for (const auto& e : index_toc["files"].GetArray()) {
@@ -419,50 +635,185 @@ class IndexWriterWorker final {
   static inline void PersistDeletes(IndexPayload* payload) {
     // only loop through segments if any delete has happened
     if (payload->any_delete_) {
+      bool any_persisted = false;
       for (segment_t& s : *payload->segments_) {
         if (s->Persist()) {
           s->ReloadDeletedKeys();
+          any_persisted = true;
         }
       }
+
+      if (any_persisted) {
+        ++payload->generation_;
+      }
+
+      InvalidateValueCache(payload, &payload->value_cache_deleted_keys_);
     }
 
     // clear delete flag
     payload->any_delete_ = false;
   }
 
+  static inline void ApplyWriteBatch(IndexPayload* payload, const WriteBatch& write_batch) {
+    TRACE("apply write batch: %ul", write_batch.size());
+
+    encoded_value_t encoded_value;
+    write_batch.ForEach([payload, &encoded_value](const WriteBatch::Operation operation, const std::string& key,
+                                                  const std::string& value, const int32_t hashcode) {
+      switch (operation) {
+        case WriteBatch::Operation::SET:
+          AddKey(payload, key, value);
+          break;
+        case WriteBatch::Operation::SET_ENCODED:
+          encoded_value.value_ = value;
+          encoded_value.hashcode_ = hashcode;
+          AddEncodedKey(payload, key, encoded_value);
+          break;
+        case WriteBatch::Operation::DELETE:
+          DeleteKey(payload, key);
+          break;
+      }
+    });
+  }
+
+  static inline void AddKey(IndexPayload* payload, const std::string& key, const std::string& value) {
+    CreateCompilerIfNeeded(payload);
+    payload->compiler_->Add(key, value);
+    if (payload->value_cache_) {
+      payload->value_cache_written_keys_.push_back(key);
+    }
+  }
+
+  static inline void AddEncodedKey(IndexPayload* payload, const std::string& key,
+                                   const encoded_value_t& encoded_value) {
+    CreateCompilerIfNeeded(payload);
+    payload->compiler_->AddEncoded(key, encoded_value);
+    if (payload->value_cache_) {
+      payload->value_cache_written_keys_.push_back(key);
+    }
+  }
+
+  static inline void DeleteKey(IndexPayload* payload, const std::string& key) {
+    if (payload->settings_.GetTombstones()) {
+      AddTombstone(payload, key);
+      return;
+    }
+
+    payload->any_delete_ = true;
+
+    if (payload->compiler_) {
+      payload->compiler_->Delete(key);
+    }
+
+    for (CompileJob& compile_job : payload->compile_jobs_) {
+      compile_job.DeleteKey(key);
+    }
+
+    if (payload->segments_) {
+      for (const segment_t& s : *payload->segments_) {
+        s->DeleteKey(key);
+      }
+    }
+
+    if (payload->value_cache_) {
+      payload->value_cache_deleted_keys_.push_back(key);
+    }
+  }
+
+  /**
+   * Delete by writing a tombstone into the next segment, older segments are not touched.
+   */
+  static inline void AddTombstone(IndexPayload* payload, const std::string& key) {
+    CreateCompilerIfNeeded(payload);
+    payload->compiler_->Delete(key);
+
+    // like a write the delete becomes visible with the next segment
+    if (payload->value_cache_) {
+      payload->value_cache_written_keys_.push_back(key);
+    }
+  }
+
   static inline void CreateCompilerIfNeeded(IndexPayload* payload) {
     if (!payload->compiler_) {
       TRACE("recreate compiler");
-      keyvi::util::parameters_t params = keyvi::util::parameters_t{{"memory_limit_mb", "5"}};
-
-      payload->compiler_.reset(new dictionary::JsonDictionaryIndexCompiler(params));
+      payload->compiler_ =
+          SegmentCompilerInterface::Create(payload->value_store_type_, CompilerParams(payload->settings_));
     }
   }
 
+  /**
+   * Parameters for the compiler, value encoders must be created with the same parameters.
+   */
+  static keyvi::util::parameters_t CompilerParams(const IndexSettings& settings) {
+    return keyvi::util::parameters_t{{"memory_limit_mb", "5"},
+                                     {KEY_FILTER_BITS_PER_KEY, std::to_string(settings.GetKeyFilterBitsPerKey())},
+                                     {TOMBSTONES_KEY, settings.GetTombstones() ? "true" : "false"}};
+  }
+
+  /**
+   * Seal the current compiler and compile it in the background, new writes go into a new compiler.
+   *
+   * If too many compiles are running, wait for the oldest one, this throttles the writer.
+   */
   static inline void Compile(IndexPayload* payload) {
     if (!payload->compiler_) {
       TRACE("no compiler found");
       return;
     }
 
+    while (payload->compile_jobs_.size() >= payload->max_concurrent_compiles_) {
+      payload->compile_jobs_.front().Finalize();
+      PublishCompiledSegments(payload);
+    }
+
     boost::filesystem::path p(payload->index_directory_);
     p /= boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.kv");
 
-    TRACE("compiling");
-    payload->compiler_->Compile();
-    TRACE("write to file [%s] [%s]", p.string().c_str(), p.filename().string().c_str());
+    TRACE("compiling [%s]", p.string().c_str());
+    payload->compile_jobs_.emplace_back(payload->compiler_, p, std::move(payload->value_cache_written_keys_));
+    payload->value_cache_written_keys_.clear();
+    payload->compiler_.reset();
+    payload->compile_jobs_.back().Run(payload->compile_job_done_);
+  }
 
-    payload->compiler_->WriteToFile(p.string());
+  /**
+   * Wait for all compiles and publish the segments.
+   */
+  static inline void WaitForCompileJobs(IndexPayload* payload) {
+    for (CompileJob& compile_job : payload->compile_jobs_) {
+      compile_job.Finalize();
+    }
+    PublishCompiledSegments(payload);
+  }
 
-    // free resources
-    payload->compiler_.reset();
+  /**
+   * Add the segments of finished compiles to the index.
+   *
+   * Segments are published in the order the compilers have been sealed, a finished compile waits for all older ones,
+   * so a newer value always ends up in a newer segment.
+   */
+  static inline void PublishCompiledSegments(IndexPayload* payload) {
+    if (payload->compile_jobs_.empty() || !payload->compile_jobs_.front().Done()) {
+      return;
+    }
 
-    // add/register new segment
+    // add/register new segments
     // we have to copy the segments (shallow copy/list of shared pointers to segments)
     // and then swap it
-    segment_t new_segment(new Segment(p, true));
     segments_t new_segments = std::make_shared<segment_vec_t>(*payload->segments_);
-    new_segments->push_back(new_segment);
+    std::vector<std::string> written_keys;
+
+    while (!payload->compile_jobs_.empty() && payload->compile_jobs_.front().Done()) {
+      CompileJob& compile_job = payload->compile_jobs_.front();
+      TRACE("publish compiled segment");
+
+      new_segments->push_back(compile_job.CompiledSegment());
+      if (compile_job.HasDeletedKeys()) {
+        payload->any_delete_ = true;
+      }
+      written_keys.insert(written_keys.end(), compile_job.WrittenKeys()->begin(), compile_job.WrittenKeys()->end());
+      payload->compile_jobs_.pop_front();
+    }
 
     // thread-safe swap
     {
@@ -474,6 +825,24 @@ class IndexWriterWorker final {
 
     // reset as segments have been changed
     payload->segments_weak_.reset();
+    ++payload->generation_;
+
+    InvalidateValueCache(payload, &written_keys);
+
+    // deletes that happened during compilation
+    PersistDeletes(payload);
+  }
+
+  /**
+   * Invalidate the given keys in the value cache, must be called after the change became visible to readers.
+   */
+  static inline void InvalidateValueCache(IndexPayload* payload, std::vector<std::string>* keys) {
+    if (payload->value_cache_) {
+      for (const std::string& key : *keys) {
+        payload->value_cache_->Invalidate(key);
+      }
+    }
+    keys->clear();
   }
 
   static void WriteToc(const IndexPayload* payload) {
@@ -487,6 +856,8 @@ class IndexWriterWorker final {
       TRACE("Number of segments: %ld", payload->segments_->size());
 
       writer.StartObject();
+      writer.Key(VALUE_STORE_TYPE);
+      writer.String(payload->settings_.GetValueStoreTypeName());
       writer.Key("files");
       writer.StartArray();
       for (const auto& s : *(payload->segments_)) {
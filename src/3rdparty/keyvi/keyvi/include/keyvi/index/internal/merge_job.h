@@ -45,8 +45,12 @@ namespace internal {
 class MergeJob final {
   struct MergeJobPayload {
     explicit MergeJobPayload(std::vector<segment_t> segments, const boost::filesystem::path& output_filename,
-                             const IndexSettings& settings)
-        : segments_(segments), output_filename_(output_filename), settings_(settings), process_finished_(false) {}
+                             const IndexSettings& settings, bool drop_tombstones)
+        : segments_(segments),
+          output_filename_(output_filename),
+          settings_(settings),
+          drop_tombstones_(drop_tombstones),
+          process_finished_(false) {}
 
     MergeJobPayload() = delete;
     MergeJobPayload& operator=(MergeJobPayload const&) = delete;
@@ -55,6 +59,7 @@ class MergeJob final {
     std::vector<segment_t> segments_;
     boost::filesystem::path output_filename_;
     const IndexSettings& settings_;
+    const bool drop_tombstones_;
     std::chrono::time_point<std::chrono::system_clock> start_time_;
     std::chrono::time_point<std::chrono::system_clock> end_time_;
     int exit_code_ = -1;
@@ -64,9 +69,12 @@ class MergeJob final {
 
  public:
   // todo: add ability to stop merging for shutdown
+  /**
+   * @param drop_tombstones whether the merged segment will be the oldest segment, in which case tombstones are dropped
+   */
   explicit MergeJob(segment_vec_t segments, size_t id, const boost::filesystem::path& output_filename,
-                    const IndexSettings& settings)
-      : payload_(segments, output_filename, settings), id_(id), external_process_() {}
+                    const IndexSettings& settings, bool drop_tombstones = false)
+      : payload_(segments, output_filename, settings, drop_tombstones), id_(id), external_process_() {}
 
   ~MergeJob() {
     if (payload_.process_finished_ == false) {
@@ -140,12 +148,22 @@ class MergeJob final {
 
         // todo: make this configurable
         params[MEMORY_LIMIT_KEY] = "5242880";
-        keyvi::dictionary::JsonDictionaryMerger jsonDictionaryMerger(params);
-        for (const segment_t& s : payload_.segments_) {
-          jsonDictionaryMerger.Add(s->GetDictionaryPath().string());
+        params[KEY_FILTER_BITS_PER_KEY] = std::to_string(payload_.settings_.GetKeyFilterBitsPerKey());
+        params[MERGE_DROP_TOMBSTONES] = payload_.drop_tombstones_ ? "true" : "false";
+
+        switch (payload_.settings_.GetValueStoreType()) {
+          case dictionary::fsa::internal::value_store_t::STRING:
+            Merge<dictionary::fsa::internal::value_store_t::STRING>(params);
+            break;
+          case dictionary::fsa::internal::value_store_t::INT:
+            Merge<dictionary::fsa::internal::value_store_t::INT>(params);
+            break;
+          case dictionary::fsa::internal::value_store_t::KEY_ONLY:
+            Merge<dictionary::fsa::internal::value_store_t::KEY_ONLY>(params);
+            break;
+          default:
+            Merge<dictionary::fsa::internal::value_store_t::JSON>(params);
         }
-
-        jsonDictionaryMerger.Merge(payload_.output_filename_.string());
         payload_.exit_code_ = 0;
       } catch (const std::exception& e) {
         TRACE("internal merge failed with: %s", e.what());
@@ -154,6 +172,16 @@ class MergeJob final {
     });
   }
 
+  template <dictionary::fsa::internal::value_store_t ValueStoreType>
+  void Merge(const keyvi::util::parameters_t& params) {
+    keyvi::dictionary::DictionaryMerger<ValueStoreType> dictionary_merger(params);
+    for (const segment_t& s : payload_.segments_) {
+      dictionary_merger.Add(s->GetDictionaryPath().string());
+    }
+
+    dictionary_merger.Merge(payload_.output_filename_.string());
+  }
+
   void DoExternalProcessMerge() {
     payload_.start_time_ = std::chrono::system_clock::now();
 
@@ -161,6 +189,8 @@ class MergeJob final {
 
     command << payload_.settings_.GetKeyviMergerBin();
     command << " -m 5242880";
+    command << " -p " << KEY_FILTER_BITS_PER_KEY << "=" << payload_.settings_.GetKeyFilterBitsPerKey();
+    command << " -p " << MERGE_DROP_TOMBSTONES << "=" << (payload_.drop_tombstones_ ? "true" : "false");
 
     for (auto s : payload_.segments_) {
       command << " -i " << s->GetDictionaryPath().string();
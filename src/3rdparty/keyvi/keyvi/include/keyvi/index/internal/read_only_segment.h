@@ -25,13 +25,14 @@
 #ifndef KEYVI_INDEX_INTERNAL_READ_ONLY_SEGMENT_H_
 #define KEYVI_INDEX_INTERNAL_READ_ONLY_SEGMENT_H_
 
+#include <cstdint>
 #include <cstdio>
 #include <ctime>
+#include <iterator>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -39,6 +40,11 @@
 #include <msgpack.hpp>
 
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/util/key_filter.h"
+#include "keyvi/index/internal/deleted_key_set.h"
+#include "keyvi/index/internal/deleted_keys_journal.h"
+#include "keyvi/index/internal/tombstones_file.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -49,8 +55,9 @@ namespace internal {
 
 class ReadOnlySegment {
  public:
-  using deleted_t = std::unordered_set<std::string>;
+  using deleted_t = DeletedKeysOverlay;
   using deleted_ptr_t = std::shared_ptr<deleted_t>;
+  using tombstones_ptr_t = std::shared_ptr<const DeletedKeySet>;
 
   explicit ReadOnlySegment(const boost::filesystem::path& path)
       : dictionary_path_(path),
@@ -60,10 +67,12 @@ class ReadOnlySegment {
         deleted_keys_during_merge_path_(path),
         dictionary_filename_(path.filename().string()),
         dictionary_(),
+        key_filter_(),
+        tombstones_(),
         has_deleted_keys_(false),
         deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_state_(),
+        deleted_keys_during_merge_state_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
 
@@ -77,6 +86,21 @@ class ReadOnlySegment {
 
   dictionary::dictionary_properties_t& GetDictionaryProperties() { return dictionary_properties_; }
 
+  /**
+   * Check the key filter, false if the segment definitely does not contain the key.
+   */
+  bool MayContain(const std::string& key) const { return !key_filter_ || key_filter_->MayContain(key); }
+
+  /**
+   * Keys deleted by this segment in all older segments, nullptr if the segment has no tombstones.
+   */
+  const tombstones_ptr_t& Tombstones() const { return tombstones_; }
+
+  /**
+   * Check whether this segment hides the key in all older segments.
+   */
+  bool HasTombstone(const std::string& key) const { return tombstones_ && tombstones_->count(key) > 0; }
+
   bool HasDeletedKeys() { return has_deleted_keys_; }
 
   size_t DeletedKeysSize() const {
@@ -108,7 +132,10 @@ class ReadOnlySegment {
     return false;
   }
 
-  void ReloadDeletedKeys() { LoadDeletedKeys(); }
+  /**
+   * Reload the deleted keys, returns true if the deleted keys have changed.
+   */
+  bool ReloadDeletedKeys() { return LoadDeletedKeys(); }
 
   const boost::filesystem::path& GetDictionaryPath() const { return dictionary_path_; }
 
@@ -127,10 +154,12 @@ class ReadOnlySegment {
         deleted_keys_during_merge_path_(path),
         dictionary_filename_(path.filename().string()),
         dictionary_(),
+        key_filter_(),
+        tombstones_(),
         has_deleted_keys_(false),
         deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_state_(),
+        deleted_keys_during_merge_state_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
 
@@ -151,10 +180,12 @@ class ReadOnlySegment {
         deleted_keys_during_merge_path_(dictionary_path_),
         dictionary_filename_(dictionary_path_.filename().string()),
         dictionary_(),
+        key_filter_(),
+        tombstones_(),
         has_deleted_keys_(false),
         deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_state_(),
+        deleted_keys_during_merge_state_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
 
@@ -170,52 +201,59 @@ class ReadOnlySegment {
   void LoadDictionary() {
     // load dictionary
     dictionary_.reset(new dictionary::Dictionary(dictionary_path_.string()));
+
+    // optional, segments written without a filter are always searched
+    key_filter_ = dictionary::util::KeyFilter::FromFile(dictionary_path_.string() + KEY_FILTER_FILE_SUFFIX);
+
+    // optional, only segments compiled with tombstones enabled have them
+    std::vector<std::string> tombstones = TombstonesFile::Read(dictionary_path_.string());
+    if (!tombstones.empty()) {
+      tombstones_ = std::make_shared<DeletedKeySet>(std::move(tombstones));
+    }
   }
 
-  void LoadDeletedKeys() {
+  bool LoadDeletedKeys() {
     TRACE("load deleted keys");
 
-    boost::system::error_code ec;
-    std::time_t last_write_dk = boost::filesystem::last_write_time(deleted_keys_path_, ec);
-    // effectively ignore if file does not exist
-    if (ec) {
-      last_write_dk = last_modification_time_deleted_keys_;
-    }
+    std::vector<std::string> new_keys;
+    ReadDeletedKeys(deleted_keys_path_, &deleted_keys_state_, &new_keys);
+    ReadDeletedKeys(deleted_keys_during_merge_path_, &deleted_keys_during_merge_state_, &new_keys);
 
-    std::time_t last_write_dkm = boost::filesystem::last_write_time(deleted_keys_during_merge_path_, ec);
-    // effectively ignore if file does not exist
-    if (ec) {
-      last_write_dkm = last_modification_time_deleted_keys_during_merge_;
+    if (new_keys.empty()) {
+      return false;
     }
 
-    // if any list has changed, reload it
-    if (last_write_dk > last_modification_time_deleted_keys_ ||
-        last_write_dkm > last_modification_time_deleted_keys_during_merge_) {
-      TRACE("found deleted keys");
+    TRACE("found deleted keys: %d", new_keys.size());
 
-      deleted_ptr_t deleted_keys = std::make_shared<deleted_t>();
-      deleted_t deleted_keys_dk = LoadAndUnserializeDeletedKeys(deleted_keys_path_.string());
-      TRACE("Loaded deleted keys: %d", deleted_keys_dk.size());
-
-      deleted_keys->swap(deleted_keys_dk);
-      // deleted_keys->insert(deleted_keys_dk.begin(), deleted_keys_dk.end());
-      deleted_t deleted_keys_dkm = LoadAndUnserializeDeletedKeys(deleted_keys_during_merge_path_.string());
-      TRACE("Loaded deleted keys m: %d", deleted_keys_dkm.size());
+    // copy-on-write: the copy shares the compacted keys, only the recently added ones get copied
+    const size_t previous_size = DeletedKeysSize();
+    deleted_ptr_t deleted_keys =
+        has_deleted_keys_ ? std::make_shared<deleted_t>(*deleted_keys_) : std::make_shared<deleted_t>();
+    for (const std::string& key : new_keys) {
+      deleted_keys->Insert(key);
+    }
 
-      deleted_keys->insert(deleted_keys_dkm.begin(), deleted_keys_dkm.end());
+    // keys are never undeleted, so the list has changed if it has grown
+    if (deleted_keys->size() == previous_size) {
+      return false;
+    }
 
-      // safe swap
-      {
-        std::unique_lock<std::mutex> lock(mutex_);
-        deleted_keys_.swap(deleted_keys);
-      }
-      TRACE("Number of deleted keys: %d", deleted_keys_->size());
+    if (deleted_keys->NeedsCompaction()) {
+      deleted_keys->Compact();
+    }
 
-      has_deleted_keys_ = true;
+    // safe swap
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      deleted_keys_.swap(deleted_keys);
     }
+    TRACE("Number of deleted keys: %d", deleted_keys_->size());
+
+    has_deleted_keys_ = true;
+    return true;
   }
 
-  const deleted_t& DeletedKeysDirect() const { return *deleted_keys_; }
+  const deleted_ptr_t& DeletedKeysDirect() const { return deleted_keys_; }
 
  private:
   //! path of the underlying dictionary
@@ -236,6 +274,12 @@ class ReadOnlySegment {
   //! the dictionary itself
   dictionary::dictionary_t dictionary_;
 
+  //! filter to skip the segment for keys it does not contain, might be empty
+  std::shared_ptr<const dictionary::util::KeyFilter> key_filter_;
+
+  //! keys deleted by this segment in older segments, immutable like the dictionary, might be empty
+  tombstones_ptr_t tombstones_;
+
   //! quick and cheap check whether this segment has deletes (assuming that deletes are rare)
   std::atomic_bool has_deleted_keys_;
 
@@ -248,16 +292,67 @@ class ReadOnlySegment {
   //! a mutex to secure access to the deleted keys shared pointer
   std::mutex mutex_;
 
-  //! last modification time for the deleted keys file
-  std::time_t last_modification_time_deleted_keys_;
+  //! what has been read from a file with deleted keys and its journal
+  struct DeletedKeysFileState {
+    DeletedKeysFileState() : last_modification_time_(0), size_(0), journal_epoch_(0), journal_offset_(0) {}
+
+    std::time_t last_modification_time_;
+    uintmax_t size_;
+    uint64_t journal_epoch_;
+    size_t journal_offset_;
+  };
+
+  //! state of the deleted keys file
+  DeletedKeysFileState deleted_keys_state_;
+
+  //! state of the deleted keys file during a merge operation
+  DeletedKeysFileState deleted_keys_during_merge_state_;
+
+  /**
+   * Read the keys that have been added to the journal since the last call, the full list gets read if the journal
+   * has been compacted or if there is no journal and the file has changed.
+   */
+  static void ReadDeletedKeys(const boost::filesystem::path& path, DeletedKeysFileState* state,
+                              std::vector<std::string>* keys) {
+    const uint64_t journal_epoch = state->journal_epoch_;
+    const bool has_journal = DeletedKeysJournal::Tail(DeletedKeysJournal::JournalFilename(path.string()),
+                                                      &state->journal_epoch_, &state->journal_offset_, keys);
+
+    // the full list only changes together with the epoch of the journal
+    if (has_journal && state->journal_epoch_ == journal_epoch) {
+      return;
+    }
+
+    if (!has_journal) {
+      state->journal_epoch_ = 0;
+      state->journal_offset_ = 0;
+    }
+
+    boost::system::error_code ec;
+    const std::time_t last_write = boost::filesystem::last_write_time(path, ec);
+    // effectively ignore if file does not exist
+    if (ec) {
+      return;
+    }
 
-  //! last modification time for the deleted keys file during a merge operation
-  std::time_t last_modification_time_deleted_keys_during_merge_;
+    const uintmax_t size = boost::filesystem::file_size(path, ec);
+    if (ec || (!has_journal && last_write == state->last_modification_time_ && size == state->size_)) {
+      return;
+    }
+
+    state->last_modification_time_ = last_write;
+    state->size_ = size;
+
+    std::vector<std::string> deleted_keys = LoadAndUnserializeDeletedKeys(path.string());
+    TRACE("Loaded deleted keys from %s: %d", path.string().c_str(), deleted_keys.size());
+    keys->insert(keys->end(), std::make_move_iterator(deleted_keys.begin()),
+                 std::make_move_iterator(deleted_keys.end()));
+  }
 
-  inline static deleted_t LoadAndUnserializeDeletedKeys(const std::string& filename) {
+  inline static std::vector<std::string> LoadAndUnserializeDeletedKeys(const std::string& filename) {
     TRACE("loading deleted keys file %s", filename.c_str());
 
-    deleted_t deleted_keys;
+    std::vector<std::string> deleted_keys;
     std::ifstream deleted_keys_stream(filename, std::ios::binary);
     if (deleted_keys_stream.good()) {
       std::stringstream buffer;
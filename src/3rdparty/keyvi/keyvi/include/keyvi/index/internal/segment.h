@@ -18,12 +18,12 @@
 #ifndef KEYVI_INDEX_INTERNAL_SEGMENT_H_
 #define KEYVI_INDEX_INTERNAL_SEGMENT_H_
 
+#include <algorithm>
 #include <cstdio>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -31,7 +31,10 @@
 #include <msgpack.hpp>
 
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/index/internal/deleted_key_set.h"
+#include "keyvi/index/internal/deleted_keys_journal.h"
 #include "keyvi/index/internal/read_only_segment.h"
+#include "keyvi/index/internal/tombstones_file.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -46,11 +49,13 @@ class Segment final : public ReadOnlySegment {
  public:
   using deleted_t = ReadOnlySegment::deleted_t;
   using deleted_ptr_t = ReadOnlySegment::deleted_ptr_t;
+  using tombstones_ptr_t = ReadOnlySegment::tombstones_ptr_t;
 
   explicit Segment(const boost::filesystem::path& path, bool no_deletes = false)
       : ReadOnlySegment(path, false, !no_deletes),
         deleted_keys_for_write_(),
         deleted_keys_during_merge_for_write_(),
+        deleted_keys_to_persist_(),
         dictionary_loaded(false),
         deletes_loaded(no_deletes),
         in_merge_(false),
@@ -63,6 +68,7 @@ class Segment final : public ReadOnlySegment {
       : ReadOnlySegment(path, false, false),
         deleted_keys_for_write_(),
         deleted_keys_during_merge_for_write_(),
+        deleted_keys_to_persist_(),
         lazy_load_mutex_(),
         dictionary_loaded(false),
         deletes_loaded(true),
@@ -73,14 +79,12 @@ class Segment final : public ReadOnlySegment {
 
     // move deletions that happened during merge into the list of deleted keys
     for (const auto& p_segment : parent_segments) {
-      deleted_keys_for_write_.insert(p_segment->deleted_keys_during_merge_for_write_.begin(),
-                                     p_segment->deleted_keys_during_merge_for_write_.end());
+      deleted_keys_for_write_.Insert(p_segment->deleted_keys_during_merge_for_write_);
     }
 
     // persist the current list of deleted keys
     if (deleted_keys_for_write_.size()) {
-      new_delete_ = true;
-      Persist();
+      CompactDeletedKeys(GetDeletedKeysPath().string(), &deleted_keys_for_write_);
     }
   }
 
@@ -94,6 +98,21 @@ class Segment final : public ReadOnlySegment {
     return ReadOnlySegment::GetDictionary();
   }
 
+  bool MayContain(const std::string& key) {
+    LazyLoadDictionary();
+    return ReadOnlySegment::MayContain(key);
+  }
+
+  const tombstones_ptr_t& Tombstones() {
+    LazyLoadDictionary();
+    return ReadOnlySegment::Tombstones();
+  }
+
+  bool HasTombstone(const std::string& key) {
+    LazyLoadDictionary();
+    return ReadOnlySegment::HasTombstone(key);
+  }
+
   bool HasDeletedKeys() {
     LazyLoadDeletedKeys();
     return deleted_keys_for_write_.size() + deleted_keys_during_merge_for_write_.size() > 0;
@@ -122,14 +141,15 @@ class Segment final : public ReadOnlySegment {
   void MergeFailed() {
     in_merge_ = false;
     if (deleted_keys_during_merge_for_write_.size() > 0) {
-      deleted_keys_for_write_.insert(deleted_keys_during_merge_for_write_.begin(),
-                                     deleted_keys_during_merge_for_write_.end());
+      deleted_keys_for_write_.Insert(deleted_keys_during_merge_for_write_);
 
-      new_delete_ = true;
-      Persist();
+      CompactDeletedKeys(GetDeletedKeysPath().string(), &deleted_keys_for_write_);
+      deleted_keys_to_persist_.clear();
+      new_delete_ = false;
       deleted_keys_during_merge_for_write_.clear();
-      // remove dkm file
+      // remove dkm file and its journal
       std::remove(GetDeletedKeysDuringMergePath().string().c_str());
+      std::remove(DeletedKeysJournal::JournalFilename(GetDeletedKeysDuringMergePath().string()).c_str());
     }
   }
 
@@ -143,49 +163,89 @@ class Segment final : public ReadOnlySegment {
   void RemoveFiles() {
     // delete files, not all files might exist, therefore ignore the output
     std::remove(GetDictionaryPath().string().c_str());
+    std::remove((GetDictionaryPath().string() + KEY_FILTER_FILE_SUFFIX).c_str());
+    std::remove(TombstonesFile::Filename(GetDictionaryPath().string()).c_str());
     std::remove(GetDeletedKeysDuringMergePath().string().c_str());
+    std::remove(DeletedKeysJournal::JournalFilename(GetDeletedKeysDuringMergePath().string()).c_str());
     std::remove(GetDeletedKeysPath().string().c_str());
+    std::remove(DeletedKeysJournal::JournalFilename(GetDeletedKeysPath().string()).c_str());
   }
 
   void DeleteKey(const std::string& key) {
-    if (!GetDictionary()->Contains(key)) {
+    if (!MayContain(key) || !GetDictionary()->Contains(key)) {
       return;
     }
 
-    // load deleted keys as well
-    LazyLoadDeletedKeys();
+    MarkDeleted(key);
+  }
 
-    if (in_merge_) {
-      TRACE("delete key (in merge) %s", key.c_str());
-      deleted_keys_during_merge_for_write_.insert(key);
-    } else {
-      TRACE("delete key (no merge) %s", key.c_str());
-      deleted_keys_for_write_.insert(key);
+  /**
+   * Delete a batch of keys, the keys must be sorted.
+   *
+   * The keys are checked in a single co-traversal of the FSA: the states along the previous key are kept, so the
+   * shared prefix of consecutive keys is walked only once.
+   */
+  void DeleteKeys(const std::vector<std::string>& sorted_keys) {
+    const dictionary::fsa::automata_t fsa = GetDictionary()->GetFsa();
+
+    // states[i] is the state after walking i characters of the last walked key
+    std::vector<uint64_t> states{fsa->GetStartState()};
+    const std::string* last_key = nullptr;
+
+    for (const std::string& key : sorted_keys) {
+      if (!ReadOnlySegment::MayContain(key)) {
+        continue;
+      }
+
+      size_t depth = 0;
+      if (last_key) {
+        const size_t max_depth = std::min(key.size(), states.size() - 1);
+        while (depth < max_depth && key[depth] == (*last_key)[depth]) {
+          ++depth;
+        }
+      }
+      states.resize(depth + 1);
+      last_key = &key;
+
+      uint64_t state = states.back();
+      while (depth < key.size()) {
+        state = fsa->TryWalkTransition(state, key[depth]);
+        if (!state) {
+          break;
+        }
+        states.push_back(state);
+        ++depth;
+      }
+
+      if (state && fsa->IsFinalState(state)) {
+        MarkDeleted(key);
+      }
     }
-    new_delete_ = true;
   }
 
-  // persist deleted keys
+  // persist deleted keys, returns false if there was nothing to persist
   bool Persist() {
     if (!new_delete_) {
       return false;
     }
     TRACE("persist deleted keys");
-    boost::filesystem::path deleted_keys_file = GetDictionaryPath();
 
     // its ensured that before merge persist is called, so we have to persist only one or the other file
     if (in_merge_) {
-      SaveDeletedKeys(GetDeletedKeysDuringMergePath().string(), deleted_keys_during_merge_for_write_);
+      PersistDeletedKeys(GetDeletedKeysDuringMergePath().string(), &deleted_keys_during_merge_for_write_);
     } else {
-      SaveDeletedKeys(GetDeletedKeysPath().string(), deleted_keys_for_write_);
+      PersistDeletedKeys(GetDeletedKeysPath().string(), &deleted_keys_for_write_);
     }
 
+    deleted_keys_to_persist_.clear();
+    new_delete_ = false;
     return true;
   }
 
  private:
-  deleted_t deleted_keys_for_write_;
-  deleted_t deleted_keys_during_merge_for_write_;
+  DeletedKeysOverlay deleted_keys_for_write_;
+  DeletedKeysOverlay deleted_keys_during_merge_for_write_;
+  std::vector<std::string> deleted_keys_to_persist_;
   std::mutex lazy_load_mutex_;
   bool dictionary_loaded;
   bool deletes_loaded;
@@ -200,6 +260,7 @@ class Segment final : public ReadOnlySegment {
       : ReadOnlySegment(dictionary_properties, false, !no_deletes),
         deleted_keys_for_write_(),
         deleted_keys_during_merge_for_write_(),
+        deleted_keys_to_persist_(),
         lazy_load_mutex_(),
         dictionary_loaded(false),
         deletes_loaded(no_deletes),
@@ -209,6 +270,25 @@ class Segment final : public ReadOnlySegment {
     deleted_keys_swap_filename_ += ".dk-swap";
   }
 
+  void MarkDeleted(const std::string& key) {
+    // load deleted keys as well
+    LazyLoadDeletedKeys();
+
+    bool inserted = false;
+    if (in_merge_) {
+      TRACE("delete key (in merge) %s", key.c_str());
+      inserted = deleted_keys_during_merge_for_write_.Insert(key);
+    } else {
+      TRACE("delete key (no merge) %s", key.c_str());
+      inserted = deleted_keys_for_write_.Insert(key);
+    }
+
+    if (inserted) {
+      deleted_keys_to_persist_.push_back(key);
+      new_delete_ = true;
+    }
+  }
+
   inline void LazyLoadDictionary() {
     // optimistic lock
     if (!dictionary_loaded) {
@@ -227,12 +307,12 @@ class Segment final : public ReadOnlySegment {
       if (!deletes_loaded) {
         LoadDeletedKeys();
 
-        // get a copy of the deleted keys for writing
+        // share the deleted keys with the reader, new deletes go into the overlay
         if (ReadOnlySegment::HasDeletedKeys()) {
           if (in_merge_) {
-            deleted_keys_during_merge_for_write_.insert(DeletedKeysDirect().begin(), DeletedKeysDirect().end());
+            deleted_keys_during_merge_for_write_ = *DeletedKeysDirect();
           } else {
-            deleted_keys_for_write_.insert(DeletedKeysDirect().begin(), DeletedKeysDirect().end());
+            deleted_keys_for_write_ = *DeletedKeysDirect();
           }
         }
         deletes_loaded = true;
@@ -240,11 +320,35 @@ class Segment final : public ReadOnlySegment {
     }
   }
 
-  void SaveDeletedKeys(const std::string& filename, const deleted_t& deleted_keys) {
+  /**
+   * Append new deletes to the journal, rewrite the full list instead if the journal has grown too big.
+   */
+  void PersistDeletedKeys(const std::string& filename, DeletedKeysOverlay* deleted_keys) {
+    if (deleted_keys->NeedsCompaction()) {
+      CompactDeletedKeys(filename, deleted_keys);
+      return;
+    }
+
+    DeletedKeysJournal::Append(DeletedKeysJournal::JournalFilename(filename), deleted_keys_to_persist_);
+  }
+
+  /**
+   * Write the full list and start a new journal, the order matters for readers tailing the journal.
+   */
+  void CompactDeletedKeys(const std::string& filename, DeletedKeysOverlay* deleted_keys) {
+    SaveDeletedKeys(filename, deleted_keys);
+    DeletedKeysJournal::Create(DeletedKeysJournal::JournalFilename(filename));
+  }
+
+  void SaveDeletedKeys(const std::string& filename, DeletedKeysOverlay* deleted_keys) {
+    const std::shared_ptr<const DeletedKeySet>& compacted_keys = deleted_keys->Compact();
+
     // write to swap file, than rename it
     {
       std::ofstream out_stream(deleted_keys_swap_filename_.string(), std::ios::binary);
-      msgpack::pack(out_stream, deleted_keys);
+      msgpack::packer<std::ofstream> packer(&out_stream);
+      packer.pack_array(compacted_keys->size());
+      compacted_keys->ForEach([&packer](const std::string& key) { packer.pack(key); });
     }
     std::rename(deleted_keys_swap_filename_.string().c_str(), filename.c_str());
   }
@@ -0,0 +1,179 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * segment_compiler.h
+ *
+ *  Created on: Aug 2, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_SEGMENT_COMPILER_H_
+#define KEYVI_INDEX_INTERNAL_SEGMENT_COMPILER_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "keyvi/dictionary/dictionary_types.h"
+#include "keyvi/dictionary/fsa/internal/json_value_store.h"
+#include "keyvi/util/configuration.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Compiler for a new segment, hides the value store type of the index from the writer.
+ *
+ * Values are passed as strings and converted for the value store: json and string values are taken as is, int values
+ * must be decimal numbers (check with IsValidValue before handing them to the writer thread), key-only indexes ignore
+ * the value.
+ */
+class SegmentCompilerInterface {
+ public:
+  using SegmentCompilerPtr = std::unique_ptr<SegmentCompilerInterface>;
+
+  static SegmentCompilerPtr Create(dictionary::fsa::internal::value_store_t value_store_type,
+                                   const keyvi::util::parameters_t& params);
+
+  /**
+   * Whether the value can be stored in a value store of the given type.
+   */
+  static bool IsValidValue(dictionary::fsa::internal::value_store_t value_store_type, const std::string& value) {
+    uint64_t int_value;
+    return value_store_type != dictionary::fsa::internal::value_store_t::INT || ParseIntValue(value, &int_value);
+  }
+
+  virtual ~SegmentCompilerInterface() {}
+
+  virtual void Add(const std::string& key, const std::string& value) = 0;
+
+  /**
+   * Add a json value encoded upfront, only supported by the json value store.
+   */
+  virtual void AddEncoded(const std::string& key, const dictionary::fsa::internal::EncodedJsonValue& value) = 0;
+
+  virtual void Delete(const std::string& key) = 0;
+
+  virtual void Compile() = 0;
+
+  virtual void WriteToFile(const std::string& filename) = 0;
+
+ protected:
+  static bool ParseIntValue(const std::string& value, uint64_t* int_value) {
+    if (value.empty()) {
+      return false;
+    }
+
+    uint64_t result = 0;
+    for (const char c : value) {
+      if (c < '0' || c > '9') {
+        return false;
+      }
+      const uint64_t digit = c - '0';
+      if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        return false;
+      }
+      result = result * 10 + digit;
+    }
+
+    *int_value = result;
+    return true;
+  }
+};
+
+template <dictionary::fsa::internal::value_store_t ValueStoreType>
+class SegmentCompiler final : public SegmentCompilerInterface {
+  using value_store_t = dictionary::fsa::internal::value_store_t;
+  using value_t =
+      typename dictionary::fsa::internal::ValueStoreComponents<ValueStoreType>::value_store_writer_t::value_t;
+
+ public:
+  explicit SegmentCompiler(const keyvi::util::parameters_t& params) : compiler_(params) {}
+
+  void Add(const std::string& key, const std::string& value) override {
+    compiler_.Add(key, ConvertValue(value, std::integral_constant<value_store_t, ValueStoreType>()));
+  }
+
+  void AddEncoded(const std::string& key, const dictionary::fsa::internal::EncodedJsonValue& value) override {
+    AddEncoded(key, value, std::integral_constant<bool, ValueStoreType == value_store_t::JSON>());
+  }
+
+  void Delete(const std::string& key) override { compiler_.Delete(key); }
+
+  void Compile() override { compiler_.Compile(); }
+
+  void WriteToFile(const std::string& filename) override { compiler_.WriteToFile(filename); }
+
+ private:
+  dictionary::DictionaryIndexCompiler<ValueStoreType> compiler_;
+
+  void AddEncoded(const std::string& key, const dictionary::fsa::internal::EncodedJsonValue& value, std::true_type) {
+    compiler_.AddEncoded(key, value);
+  }
+
+  void AddEncoded(const std::string& key, const dictionary::fsa::internal::EncodedJsonValue& value, std::false_type) {
+    throw std::logic_error("encoded values are only supported by the json value store");
+  }
+
+  static value_t ConvertValue(const std::string& value, std::integral_constant<value_store_t, value_store_t::INT>) {
+    uint64_t int_value = 0;
+    if (!ParseIntValue(value, &int_value)) {
+      throw std::invalid_argument("not an unsigned integer: " + value);
+    }
+    return int_value;
+  }
+
+  static value_t ConvertValue(const std::string& value,
+                              std::integral_constant<value_store_t, value_store_t::KEY_ONLY>) {
+    return 0;
+  }
+
+  template <typename T>
+  static value_t ConvertValue(const std::string& value, T) {
+    return value;
+  }
+};
+
+inline SegmentCompilerInterface::SegmentCompilerPtr SegmentCompilerInterface::Create(
+    dictionary::fsa::internal::value_store_t value_store_type, const keyvi::util::parameters_t& params) {
+  switch (value_store_type) {
+    case dictionary::fsa::internal::value_store_t::JSON:
+      return SegmentCompilerPtr(new SegmentCompiler<dictionary::fsa::internal::value_store_t::JSON>(params));
+    case dictionary::fsa::internal::value_store_t::STRING:
+      return SegmentCompilerPtr(new SegmentCompiler<dictionary::fsa::internal::value_store_t::STRING>(params));
+    case dictionary::fsa::internal::value_store_t::INT:
+      return SegmentCompilerPtr(new SegmentCompiler<dictionary::fsa::internal::value_store_t::INT>(params));
+    case dictionary::fsa::internal::value_store_t::KEY_ONLY:
+      return SegmentCompilerPtr(new SegmentCompiler<dictionary::fsa::internal::value_store_t::KEY_ONLY>(params));
+    default:
+      throw std::invalid_argument("value store type not supported for an index");
+  }
+}
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_SEGMENT_COMPILER_H_
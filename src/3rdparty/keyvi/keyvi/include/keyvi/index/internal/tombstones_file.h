@@ -0,0 +1,95 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * tombstones_file.h
+ *
+ *  Created on: Jul 21, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_TOMBSTONES_FILE_H_
+#define KEYVI_INDEX_INTERNAL_TOMBSTONES_FILE_H_
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <msgpack.hpp>
+
+#include "keyvi/dictionary/fsa/internal/constants.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Tombstones of a segment, stored as sidecar file next to it.
+ *
+ * A tombstone is a delete that has been written into a new segment instead of the deleted keys of the older segments:
+ * it hides the key in all segments older than the one carrying it. The segment is immutable, so are its tombstones.
+ *
+ * File format: msgpack array of the keys in sorted order, the same as for the deleted keys.
+ */
+class TombstonesFile final {
+ public:
+  static std::string Filename(const std::string& dictionary_filename) {
+    return dictionary_filename + TOMBSTONES_FILE_SUFFIX;
+  }
+
+  /**
+   * Write the tombstones of a segment, the file is written to a temporary file first and then moved into place.
+   */
+  static void Write(const std::string& dictionary_filename, const std::vector<std::string>& sorted_keys) {
+    const std::string filename = Filename(dictionary_filename);
+    const std::string swap_filename = filename + "-swap";
+    {
+      std::ofstream out_stream(swap_filename, std::ios::binary);
+      msgpack::pack(out_stream, sorted_keys);
+    }
+    std::rename(swap_filename.c_str(), filename.c_str());
+  }
+
+  /**
+   * Read the tombstones of a segment, empty if the segment has none.
+   */
+  static std::vector<std::string> Read(const std::string& dictionary_filename) {
+    std::vector<std::string> keys;
+    std::ifstream in_stream(Filename(dictionary_filename), std::ios::binary);
+    if (in_stream.good()) {
+      TRACE("found tombstones for %s", dictionary_filename.c_str());
+      std::stringstream buffer;
+      buffer << in_stream.rdbuf();
+
+      msgpack::unpacked unpacked_object;
+      msgpack::unpack(unpacked_object, buffer.str().data(), buffer.str().size());
+      unpacked_object.get().convert(keys);
+    }
+    return keys;
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_TOMBSTONES_FILE_H_
@@ -0,0 +1,199 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * value_cache.h
+ *
+ *  Created on: Jun 23, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_VALUE_CACHE_H_
+#define KEYVI_INDEX_INTERNAL_VALUE_CACHE_H_
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <mutex>  //NOLINT
+#include <string>
+#include <unordered_map>
+
+#include "keyvi/dictionary/match.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Cache for point lookups, maps a key to its match or to a negative result (key not found or deleted).
+ *
+ * Matches are stored detached from the segment they were found in, only the matched string and the raw value are
+ * kept. The cache is bounded by bytes and sharded by key, every shard is a LRU list.
+ *
+ * Invalidation is precise: the writer invalidates keys once a write or delete becomes visible. To avoid that a lookup
+ * that raced with an invalidation inserts a stale result, every shard has an epoch, which gets incremented on
+ * invalidation. A lookup remembers the epoch on a miss and the insert is rejected if the epoch has changed.
+ */
+class ValueCache final {
+ public:
+  explicit ValueCache(const size_t capacity_bytes) {
+    for (Shard& shard : shards_) {
+      shard.capacity_bytes_ = capacity_bytes / kNumberOfShards;
+    }
+  }
+
+  ValueCache& operator=(ValueCache const&) = delete;
+  ValueCache(const ValueCache& that) = delete;
+
+  /**
+   * Lookup a key.
+   *
+   * @param key the key
+   * @param match the cached match, empty for a negative result
+   * @param epoch on a miss the epoch to pass to Put
+   * @return true if the key has been found in the cache
+   */
+  bool Get(const std::string& key, dictionary::Match* match, uint64_t* epoch) {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+
+    auto it = shard.index_.find(key);
+    if (it == shard.index_.end()) {
+      *epoch = shard.epoch_;
+      return false;
+    }
+
+    // move to the front of the LRU list
+    shard.entries_.splice(shard.entries_.begin(), shard.entries_, it->second);
+    *match = it->second->match_;
+    return true;
+  }
+
+  /**
+   * Put the result of a lookup, the result is dropped if the key has been invalidated since the lookup.
+   *
+   * @param key the key
+   * @param epoch the epoch returned by Get
+   * @param match the match, empty for a negative result
+   */
+  void Put(const std::string& key, const uint64_t epoch, const dictionary::Match& match) {
+    dictionary::Match detached;
+    if (!match.IsEmpty()) {
+      detached = dictionary::Match(0, key.size(), key, static_cast<uint32_t>(match.GetScore()));
+      detached.SetRawValue(match.GetRawValueAsString());
+    }
+
+    const size_t bytes = 2 * key.size() + detached.GetRawValueAsString().size() + kEntryOverhead;
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+
+    if (epoch != shard.epoch_ || bytes > shard.capacity_bytes_ || shard.index_.count(key) > 0) {
+      return;
+    }
+
+    shard.entries_.emplace_front(key, detached, bytes);
+    shard.index_.emplace(key, shard.entries_.begin());
+    shard.bytes_ += bytes;
+
+    while (shard.bytes_ > shard.capacity_bytes_) {
+      Erase(&shard, std::prev(shard.entries_.end()));
+    }
+  }
+
+  /**
+   * Invalidate a key, to be called after a change of the key became visible to readers.
+   */
+  void Invalidate(const std::string& key) {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+
+    ++shard.epoch_;
+    auto it = shard.index_.find(key);
+    if (it != shard.index_.end()) {
+      Erase(&shard, it->second);
+    }
+  }
+
+  /**
+   * Invalidate all keys.
+   */
+  void Clear() {
+    for (Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex_);
+      ++shard.epoch_;
+      shard.entries_.clear();
+      shard.index_.clear();
+      shard.bytes_ = 0;
+    }
+  }
+
+  size_t Bytes() {
+    size_t bytes = 0;
+    for (Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex_);
+      bytes += shard.bytes_;
+    }
+    return bytes;
+  }
+
+ private:
+  static const size_t kNumberOfShards = 16;
+
+  // rough estimate of the bookkeeping cost per entry: list node, hash node, match object
+  static const size_t kEntryOverhead = 256;
+
+  struct Entry {
+    Entry(const std::string& key, const dictionary::Match& match, const size_t bytes)
+        : key_(key), match_(match), bytes_(bytes) {}
+
+    std::string key_;
+    dictionary::Match match_;
+    size_t bytes_;
+  };
+
+  using entries_t = std::list<Entry>;
+
+  struct Shard {
+    Shard() : epoch_(0), bytes_(0), capacity_bytes_(0) {}
+
+    std::mutex mutex_;
+    uint64_t epoch_;
+    size_t bytes_;
+    size_t capacity_bytes_;
+    entries_t entries_;
+    std::unordered_map<std::string, entries_t::iterator> index_;
+  };
+
+  Shard shards_[kNumberOfShards];
+
+  Shard& GetShard(const std::string& key) { return shards_[std::hash<std::string>()(key) % kNumberOfShards]; }
+
+  static void Erase(Shard* shard, entries_t::iterator entry) {
+    shard->bytes_ -= entry->bytes_;
+    shard->index_.erase(entry->key_);
+    shard->entries_.erase(entry);
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_VALUE_CACHE_H_
@@ -0,0 +1,135 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * write_batch.h
+ *
+ *  Created on: Jul 26, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_WRITE_BATCH_H_
+#define KEYVI_INDEX_INTERNAL_WRITE_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "keyvi/util/vint.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Single key writes collected in one buffer, to be applied in bulk by the writer thread.
+ *
+ * Every record is appended to an arena as operation code followed by the length prefixed key and value, so a write
+ * costs a copy into the buffer instead of allocating a closure per write. Records are replayed in insertion order.
+ * Values encoded upfront additionally carry the hashcode of the encoded value.
+ *
+ * Not thread-safe, the owner has to synchronize appends and seal the batch before handing it to the writer thread.
+ */
+class WriteBatch final {
+ public:
+  enum class Operation : uint8_t { SET = 0, DELETE = 1, SET_ENCODED = 2 };
+
+  WriteBatch() : records_(), size_(0) { records_.reserve(kInitialArenaSize); }
+
+  WriteBatch& operator=(WriteBatch const&) = delete;
+  WriteBatch(const WriteBatch& that) = delete;
+
+  void Set(const std::string& key, const std::string& value) { Append(Operation::SET, key, value); }
+
+  /**
+   * Set an encoded value, see dictionary::fsa::internal::JsonValueEncoder.
+   */
+  void SetEncoded(const std::string& key, const std::string& encoded_value, const int32_t hashcode) {
+    Append(Operation::SET_ENCODED, key, encoded_value);
+    records_.append(reinterpret_cast<const char*>(&hashcode), sizeof(hashcode));
+  }
+
+  void Delete(const std::string& key) { Append(Operation::DELETE, key, std::string()); }
+
+  /**
+   * Call the given function(operation, key, value, hashcode) for every record in insertion order, key and value are
+   * only valid during the call. The hashcode is only set for encoded values.
+   */
+  template <typename FuncT>
+  void ForEach(FuncT func) const {
+    std::string key;
+    std::string value;
+    const char* position = records_.data();
+    const char* end = records_.data() + records_.size();
+
+    while (position < end) {
+      const Operation operation = static_cast<Operation>(*position++);
+      size_t length = 0;
+
+      position = keyvi::util::decodeVarintString(position, &length);
+      key.assign(position, length);
+      position += length;
+
+      position = keyvi::util::decodeVarintString(position, &length);
+      value.assign(position, length);
+      position += length;
+
+      int32_t hashcode = 0;
+      if (operation == Operation::SET_ENCODED) {
+        std::memcpy(&hashcode, position, sizeof(hashcode));
+        position += sizeof(hashcode);
+      }
+
+      func(operation, key, value, hashcode);
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Memory usage of the arena in bytes.
+   */
+  size_t SizeInBytes() const { return records_.capacity(); }
+
+ private:
+  static const size_t kInitialArenaSize = 64 * 1024;
+
+  std::string records_;
+  size_t size_;
+
+  void Append(const Operation operation, const std::string& key, const std::string& value) {
+    size_t written_bytes = 0;
+    records_.push_back(static_cast<char>(operation));
+    keyvi::util::encodeVarint(key.size(), &records_, &written_bytes);
+    records_.append(key);
+    keyvi::util::encodeVarint(value.size(), &records_, &written_bytes);
+    records_.append(value);
+    ++size_;
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_WRITE_BATCH_H_
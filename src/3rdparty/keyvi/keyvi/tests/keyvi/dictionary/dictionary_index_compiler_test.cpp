@@ -29,6 +29,7 @@
 #include "keyvi/dictionary/dictionary_index_compiler.h"
 #include "keyvi/dictionary/dictionary_types.h"
 #include "keyvi/dictionary/fsa/entry_iterator.h"
+#include "keyvi/index/internal/tombstones_file.h"
 
 namespace keyvi {
 namespace dictionary {
@@ -189,6 +190,172 @@ BOOST_AUTO_TEST_CASE(parallel_sort_bug) {
   BOOST_CHECK(d.Contains("42"));
 }
 
+BOOST_AUTO_TEST_CASE(parallelSortLastWriteWins) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}, {PARALLEL_SORT_THRESHOLD_KEY, "100"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+
+  // 5 rounds of writes in random key order, every 3rd key of the last round is deleted
+  for (size_t round = 0; round < 5; ++round) {
+    for (size_t i = 0; i < 10000; ++i) {
+      const size_t key = (i * 7919) % 10000;
+      if (round == 4 && key % 3 == 0) {
+        compiler.Delete("key-" + std::to_string(key));
+      } else {
+        compiler.Add("key-" + std::to_string(key), std::to_string(round));
+      }
+    }
+  }
+  compiler.Compile();
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+
+  Dictionary d(file_name.c_str());
+  for (size_t i = 0; i < 10000; ++i) {
+    if (i % 3 == 0) {
+      BOOST_CHECK(!d.Contains("key-" + std::to_string(i)));
+    } else {
+      BOOST_CHECK_EQUAL("4", d["key-" + std::to_string(i)].GetValueAsString());
+    }
+  }
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(encodedValues) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+  fsa::internal::JsonValueEncoder encoder(params);
+  fsa::internal::EncodedJsonValue encoded_value;
+
+  encoder.Encode("{\"a\":1}", &encoded_value);
+  compiler.AddEncoded("aa", encoded_value);
+  compiler.Add("bb", "{\"a\":1}");
+  compiler.Add("cc", "{\"b\":2}");
+
+  // last one wins, no matter how the value was encoded
+  encoder.Encode("{\"c\":3}", &encoded_value);
+  compiler.AddEncoded("cc", encoded_value);
+  compiler.Compile();
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+
+  Dictionary d(file_name.c_str());
+  BOOST_CHECK_EQUAL("{\"a\":1}", d["aa"].GetValueAsString());
+  BOOST_CHECK_EQUAL("{\"a\":1}", d["bb"].GetValueAsString());
+  BOOST_CHECK_EQUAL("{\"c\":3}", d["cc"].GetValueAsString());
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(keyFilter) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}, {KEY_FILTER_BITS_PER_KEY, "10"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+
+  compiler.Add("aa", "\"{1:2}\"");
+  compiler.Add("bb", "\"{2:3}\"");
+  compiler.Delete("bb");
+  compiler.Compile();
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+
+  std::shared_ptr<util::KeyFilter> key_filter = util::KeyFilter::FromFile(file_name + KEY_FILTER_FILE_SUFFIX);
+  BOOST_REQUIRE(key_filter);
+  BOOST_CHECK(key_filter->MayContain("aa"));
+  BOOST_CHECK(!key_filter->MayContain("bb"));
+
+  std::remove(file_name.c_str());
+  std::remove((file_name + KEY_FILTER_FILE_SUFFIX).c_str());
+}
+
+BOOST_AUTO_TEST_CASE(tombstones) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}, {TOMBSTONES_KEY, "true"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+
+  compiler.Delete("zz");
+  compiler.Add("aa", "1");
+  compiler.Delete("bb");
+  // add after delete: no tombstone
+  compiler.Delete("cc");
+  compiler.Add("cc", "2");
+  // delete after add: tombstone, the key might exist in an older segment
+  compiler.Add("dd", "3");
+  compiler.Delete("dd");
+  compiler.Compile();
+
+  std::vector<std::string> expected_tombstones{"bb", "dd", "zz"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_tombstones.begin(), expected_tombstones.end(),
+                                compiler.GetTombstones().begin(), compiler.GetTombstones().end());
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+
+  Dictionary d(file_name.c_str());
+  BOOST_CHECK(d.Contains("aa"));
+  BOOST_CHECK(d.Contains("cc"));
+  BOOST_CHECK(!d.Contains("bb"));
+  BOOST_CHECK(!d.Contains("dd"));
+
+  std::vector<std::string> tombstones = index::internal::TombstonesFile::Read(file_name);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_tombstones.begin(), expected_tombstones.end(), tombstones.begin(),
+                                tombstones.end());
+
+  std::remove(file_name.c_str());
+  std::remove(index::internal::TombstonesFile::Filename(file_name).c_str());
+}
+
+BOOST_AUTO_TEST_CASE(onlyTombstones) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}, {TOMBSTONES_KEY, "true"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+
+  compiler.Delete("aa");
+  compiler.Compile();
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+
+  Dictionary d(file_name.c_str());
+  BOOST_CHECK(!d.Contains("aa"));
+  BOOST_CHECK_EQUAL(1, index::internal::TombstonesFile::Read(file_name).size());
+
+  std::remove(file_name.c_str());
+  std::remove(index::internal::TombstonesFile::Filename(file_name).c_str());
+}
+
+BOOST_AUTO_TEST_CASE(noTombstonesByDefault) {
+  keyvi::util::parameters_t params = {{"memory_limit_mb", "10"}};
+  keyvi::dictionary::DictionaryIndexCompiler<dictionary_type_t::JSON> compiler(params);
+
+  compiler.Add("aa", "1");
+  compiler.Delete("bb");
+  compiler.Compile();
+  BOOST_CHECK(compiler.GetTombstones().empty());
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+  BOOST_CHECK(!boost::filesystem::exists(index::internal::TombstonesFile::Filename(file_name)));
+
+  std::remove(file_name.c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace dictionary */
@@ -31,6 +31,7 @@
 #include "keyvi/dictionary/dictionary_merger.h"
 #include "keyvi/dictionary/dictionary_types.h"
 #include "keyvi/dictionary/fsa/traverser_types.h"
+#include "keyvi/index/internal/tombstones_file.h"
 #include "keyvi/testing/temp_dictionary.h"
 #include "keyvi/util/configuration.h"
 
@@ -84,6 +85,44 @@ BOOST_AUTO_TEST_CASE(MergeKeyOnlyDicts) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(MergeKeyFilter) {
+  std::vector<std::string> test_data = {"aaaa", "aabb", "aabc"};
+  testing::TempDictionary dictionary(&test_data);
+
+  std::vector<std::string> test_data2 = {"aaaaz", "aabbe"};
+  testing::TempDictionary dictionary2(&test_data2);
+
+  keyvi::util::parameters_t merge_configurations[] = {
+      {{"memory_limit_mb", "10"}, {KEY_FILTER_BITS_PER_KEY, "10"}},
+      {{"memory_limit_mb", "10"}, {"merge_mode", "append"}, {KEY_FILTER_BITS_PER_KEY, "10"}}};
+
+  for (const auto& params : merge_configurations) {
+    DictionaryMerger<> merger(params);
+    std::string filename("merged-dict-key-filter.kv");
+    merger.Add(dictionary.GetFileName());
+    merger.Add(dictionary2.GetFileName());
+
+    merger.Merge(filename);
+
+    std::shared_ptr<util::KeyFilter> key_filter = util::KeyFilter::FromFile(filename + KEY_FILTER_FILE_SUFFIX);
+    BOOST_REQUIRE(key_filter);
+    for (const std::string& key : std::vector<std::string>{"aaaa", "aabb", "aabc", "aaaaz", "aabbe"}) {
+      BOOST_CHECK(key_filter->MayContain(key));
+    }
+
+    std::remove(filename.c_str());
+    std::remove((filename + KEY_FILTER_FILE_SUFFIX).c_str());
+  }
+
+  // no filter by default
+  DictionaryMerger<> merger;
+  std::string filename("merged-dict-no-key-filter.kv");
+  merger.Add(dictionary.GetFileName());
+  merger.Merge(filename);
+  BOOST_CHECK(!boost::filesystem::exists(filename + KEY_FILTER_FILE_SUFFIX));
+  std::remove(filename.c_str());
+}
+
 BOOST_AUTO_TEST_CASE(MergeIntegerDicts) {
   std::vector<std::pair<std::string, uint32_t>> test_data = {
       {"abc", 22}, {"abbc", 24}, {"abbcd", 444}, {"abcde", 200}, {"abdd", 180}, {"bba", 10},
@@ -680,6 +719,47 @@ BOOST_AUTO_TEST_CASE(Delete) {
   std::remove(deleted_keys_file.string().c_str());
 }
 
+BOOST_AUTO_TEST_CASE(DeleteFromJournal) {
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"abcd", "{g:5}"},
+      {"efgh", "{h:3}"},
+      {"xyz", "{t:4}"},
+  };
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+
+  boost::filesystem::path deleted_keys_file{dictionary.GetFileName()};
+  deleted_keys_file += ".dk";
+  const std::string journal_file = index::internal::DeletedKeysJournal::JournalFilename(deleted_keys_file.string());
+  {
+    std::vector<std::string> deleted_keys{"xyz"};
+    std::ofstream out_stream(deleted_keys_file.string(), std::ios::binary);
+    msgpack::pack(out_stream, deleted_keys);
+  }
+  // the journal repeats a key of the deleted keys file
+  index::internal::DeletedKeysJournal::Append(journal_file, {"efgh", "xyz"});
+
+  JsonDictionaryMerger merger;
+  merger.Add(dictionary.GetFileName());
+
+  std::string filename("merge-delete-journal-dict.kv");
+  merger.Merge();
+  merger.WriteToFile(filename);
+
+  fsa::automata_t fsa(new fsa::Automata(filename.c_str()));
+  dictionary_t d(new Dictionary(fsa));
+
+  BOOST_CHECK(d->Contains("abcd"));
+  BOOST_CHECK(!d->Contains("efgh"));
+  BOOST_CHECK(!d->Contains("xyz"));
+
+  BOOST_CHECK_EQUAL(2, merger.GetStats().deleted_keys_);
+  BOOST_CHECK_EQUAL(1, merger.GetStats().number_of_keys_);
+
+  std::remove(filename.c_str());
+  std::remove(deleted_keys_file.string().c_str());
+  std::remove(journal_file.c_str());
+}
+
 BOOST_AUTO_TEST_CASE(MultipleDeletes) {
   std::vector<std::pair<std::string, std::string>> test_data1 = {
       {"abcd", "{g:5}"},   {"abbc", "{t:4}"}, {"abbcd", "{u:3}"}, {"abbd", "{v:2}"},
@@ -752,6 +832,73 @@ BOOST_AUTO_TEST_CASE(MultipleDeletes) {
   std::remove(deleted_keys_file3.string().c_str());
 }
 
+BOOST_AUTO_TEST_CASE(Tombstones) {
+  std::vector<std::pair<std::string, std::string>> test_data1 = {
+      {"abcd", "{a:1}"}, {"efgh", "{b:1}"}, {"ijkl", "{c:1}"}, {"mnop", "{d:1}"}};
+  testing::TempDictionary dictionary1 = testing::TempDictionary::makeTempDictionaryFromJson(&test_data1);
+
+  // deletes efgh and ijkl, also hides qrst in dictionaries older than the ones merged
+  std::vector<std::pair<std::string, std::string>> test_data2 = {{"mnop", "{d:2}"}};
+  testing::TempDictionary dictionary2 = testing::TempDictionary::makeTempDictionaryFromJson(&test_data2);
+  index::internal::TombstonesFile::Write(dictionary2.GetFileName(), {"efgh", "ijkl", "qrst"});
+
+  // re-adds ijkl, supersedes the tombstone
+  std::vector<std::pair<std::string, std::string>> test_data3 = {{"ijkl", "{c:3}"}};
+  testing::TempDictionary dictionary3 = testing::TempDictionary::makeTempDictionaryFromJson(&test_data3);
+
+  // no keys, only a tombstone for mnop
+  std::vector<std::pair<std::string, std::string>> test_data4 = {};
+  testing::TempDictionary dictionary4 = testing::TempDictionary::makeTempDictionaryFromJson(&test_data4);
+  index::internal::TombstonesFile::Write(dictionary4.GetFileName(), {"mnop"});
+
+  keyvi::util::parameters_t merge_configurations[] = {
+      {{"memory_limit_mb", "10"}},
+      {{"memory_limit_mb", "10"}, {"merge_mode", "append"}},
+      {{"memory_limit_mb", "10"}, {MERGE_DROP_TOMBSTONES, "true"}}};
+
+  for (const auto& params : merge_configurations) {
+    JsonDictionaryMerger merger(params);
+    merger.Add(dictionary1.GetFileName());
+    merger.Add(dictionary2.GetFileName());
+    merger.Add(dictionary3.GetFileName());
+    merger.Add(dictionary4.GetFileName());
+
+    std::string filename("merge-tombstones-dict.kv");
+    merger.Merge(filename);
+
+    fsa::automata_t fsa(new fsa::Automata(filename.c_str()));
+    dictionary_t d(new Dictionary(fsa));
+
+    BOOST_CHECK(d->Contains("abcd"));
+    BOOST_CHECK(!d->Contains("efgh"));
+    BOOST_CHECK(d->Contains("ijkl"));
+    BOOST_CHECK_EQUAL(Dictionary(dictionary3.GetFsa())["ijkl"].GetValueAsString(),
+                      d->operator[]("ijkl").GetValueAsString());
+    BOOST_CHECK(!d->Contains("mnop"));
+
+    BOOST_CHECK_EQUAL(2, merger.GetStats().number_of_keys_);
+    BOOST_CHECK_EQUAL(2, merger.GetStats().deleted_keys_);
+
+    std::vector<std::string> tombstones = index::internal::TombstonesFile::Read(filename);
+    if (keyvi::util::mapGetBool(params, MERGE_DROP_TOMBSTONES, false)) {
+      BOOST_CHECK(tombstones.empty());
+      BOOST_CHECK_EQUAL(0, merger.GetStats().tombstones_);
+    } else {
+      // the tombstone for ijkl is superseded, the others have to hide the keys in older dictionaries
+      std::vector<std::string> expected_tombstones{"efgh", "mnop", "qrst"};
+      BOOST_CHECK_EQUAL_COLLECTIONS(expected_tombstones.begin(), expected_tombstones.end(), tombstones.begin(),
+                                    tombstones.end());
+      BOOST_CHECK_EQUAL(3, merger.GetStats().tombstones_);
+    }
+
+    std::remove(filename.c_str());
+    std::remove(index::internal::TombstonesFile::Filename(filename).c_str());
+  }
+
+  std::remove(index::internal::TombstonesFile::Filename(dictionary2.GetFileName()).c_str());
+  std::remove(index::internal::TombstonesFile::Filename(dictionary4.GetFileName()).c_str());
+}
+
 BOOST_AUTO_TEST_CASE(WriteWithoutMerge) {
   JsonDictionaryMerger merger;
   const std::string filename("write-without-merger.kv");
@@ -114,6 +114,26 @@ BOOST_AUTO_TEST_CASE(minimization2) {
   BOOST_CHECK(v != w);
 }
 
+BOOST_AUTO_TEST_CASE(encoded_values) {
+  keyvi::util::parameters_t params{{TEMPORARY_PATH_KEY, "/tmp"}, {"memory_limit_mb", "10"}, {COMPRESSION_KEY, "zlib"}};
+  JsonValueStore values(params);
+  JsonValueEncoder encoder(params);
+  bool no_minimization = false;
+
+  const std::string large_value = "{\"mytestvalue\":\"" + std::string(100, 'a') + "\"}";
+  EncodedJsonValue encoded_value;
+  encoder.Encode(large_value, &encoded_value);
+
+  // encoded upfront or by the store, both minimize to the same value
+  uint64_t v = values.AddEncodedValue(encoded_value, &no_minimization);
+  BOOST_CHECK_EQUAL(v, values.AddValue(large_value, &no_minimization));
+
+  encoder.Encode("othervalue", &encoded_value);
+  uint64_t w = values.AddValue("othervalue", &no_minimization);
+  BOOST_CHECK(w > v);
+  BOOST_CHECK_EQUAL(w, values.AddEncodedValue(encoded_value, &no_minimization));
+}
+
 BOOST_AUTO_TEST_CASE(persistence) {
   JsonValueStore json_value_store(keyvi::util::parameters_t{{TEMPORARY_PATH_KEY, "/tmp"}, {"memory_limit_mb", "10"}});
   bool no_minimization = false;
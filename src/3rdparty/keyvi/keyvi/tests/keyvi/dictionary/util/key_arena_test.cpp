@@ -0,0 +1,160 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * key_arena_test.cpp
+ *
+ *  Created on: Jul 28, 2021
+ *      Author: hendrik
+ */
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/util/key_arena.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(KeyArenaTests)
+
+void CheckSortedUnique(const std::vector<std::pair<std::string, size_t>>& key_values,
+                       const size_t parallel_sort_threshold = 0) {
+  KeyArena<size_t> arena;
+  std::map<std::string, size_t> expected;
+  for (const auto& key_value : key_values) {
+    arena.Append(key_value.first, key_value.second);
+    expected[key_value.first] = key_value.second;
+  }
+  BOOST_CHECK_EQUAL(key_values.size(), arena.size());
+
+  arena.Sort(parallel_sort_threshold);
+
+  std::vector<std::pair<std::string, size_t>> actual;
+  arena.ForEachUnique([&actual](const std::string& key, const size_t value) { actual.emplace_back(key, value); });
+
+  BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+  auto expected_it = expected.cbegin();
+  for (const auto& key_value : actual) {
+    BOOST_CHECK_EQUAL(expected_it->first, key_value.first);
+    BOOST_CHECK_EQUAL(expected_it->second, key_value.second);
+    ++expected_it;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+  KeyArena<size_t> arena;
+  arena.Sort();
+
+  size_t calls = 0;
+  arena.ForEachUnique([&calls](const std::string& key, const size_t value) { ++calls; });
+  BOOST_CHECK(arena.empty());
+  BOOST_CHECK_EQUAL(0, calls);
+}
+
+BOOST_AUTO_TEST_CASE(short_keys) {
+  // keys shorter than the prefix, including keys that only differ in trailing zero bytes
+  CheckSortedUnique({{"b", 0},
+                     {"a", 1},
+                     {std::string("a\0", 2), 2},
+                     {"", 3},
+                     {"ab", 4},
+                     {std::string("a\0\0", 3), 5},
+                     {"\xff", 6},
+                     {"a", 7}});
+}
+
+BOOST_AUTO_TEST_CASE(shared_prefix) {
+  std::vector<std::pair<std::string, size_t>> key_values;
+  for (size_t i = 0; i < 1000; ++i) {
+    key_values.emplace_back("http://www.example.com/" + std::to_string((i * 7919) % 500), i);
+  }
+  key_values.emplace_back("http://w", 1000);
+  key_values.emplace_back("http://www.example.com", 1001);
+  key_values.emplace_back("http://w", 1002);
+
+  CheckSortedUnique(key_values);
+}
+
+std::vector<std::pair<std::string, size_t>> RandomKeyValues(const size_t size) {
+  std::mt19937 random_generator(42);
+  std::uniform_int_distribution<int> length_distribution(0, 20);
+  std::uniform_int_distribution<int> byte_distribution(0, 3);
+
+  // a small alphabet to get many duplicates and equal prefixes
+  std::vector<std::pair<std::string, size_t>> key_values;
+  for (size_t i = 0; i < size; ++i) {
+    std::string key(length_distribution(random_generator), 'a');
+    for (char& c : key) {
+      c = "ab\0\xff"[byte_distribution(random_generator)];
+    }
+    key_values.emplace_back(key, i);
+  }
+
+  return key_values;
+}
+
+BOOST_AUTO_TEST_CASE(last_write_wins) {
+  CheckSortedUnique(RandomKeyValues(50000));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_last_write_wins) {
+  const std::vector<std::pair<std::string, size_t>> key_values = RandomKeyValues(50000);
+  CheckSortedUnique(key_values, 1);
+  CheckSortedUnique(key_values, 1000);
+
+  // below the threshold
+  CheckSortedUnique(key_values, 100000);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_shared_prefix) {
+  // all keys share the full prefix and end up in one partition
+  std::vector<std::pair<std::string, size_t>> key_values;
+  for (size_t i = 0; i < 20000; ++i) {
+    key_values.emplace_back("http://www.example.com/" + std::to_string((i * 7919) % 5000), i);
+  }
+  for (size_t i = 0; i < 20000; ++i) {
+    key_values.emplace_back(std::to_string((i * 7919) % 5000), i);
+  }
+
+  CheckSortedUnique(key_values, 100);
+}
+
+BOOST_AUTO_TEST_CASE(clear) {
+  KeyArena<size_t> arena;
+  arena.Append("some-key-longer-than-the-prefix", 1);
+  const size_t size_in_bytes = arena.SizeInBytes();
+  BOOST_CHECK_GT(size_in_bytes, 0);
+
+  arena.clear();
+  BOOST_CHECK(arena.empty());
+  BOOST_CHECK_LT(arena.SizeInBytes(), size_in_bytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace util
+}  // namespace dictionary
+}  // namespace keyvi
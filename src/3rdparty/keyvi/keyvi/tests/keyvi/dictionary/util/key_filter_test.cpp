@@ -0,0 +1,114 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * key_filter_test.cpp
+ *
+ *  Created on: Jun 30, 2021
+ *      Author: hendrik
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/util/key_filter.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(KeyFilterTests)
+
+BOOST_AUTO_TEST_CASE(stable_hash) {
+  // the hash is part of the file format
+  BOOST_CHECK_EQUAL(0xefd01f60ba992926ULL, KeyFilter::Hash(""));
+  BOOST_CHECK_EQUAL(0x5a180dcbeeeeca9eULL, KeyFilter::Hash("keyvi"));
+}
+
+BOOST_AUTO_TEST_CASE(no_false_negatives) {
+  KeyFilter filter(10000, 10);
+
+  for (size_t i = 0; i < 10000; ++i) {
+    filter.Add("key" + std::to_string(i));
+  }
+
+  for (size_t i = 0; i < 10000; ++i) {
+    BOOST_CHECK(filter.MayContain("key" + std::to_string(i)));
+  }
+
+  size_t false_positives = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    if (filter.MayContain("other" + std::to_string(i))) {
+      ++false_positives;
+    }
+  }
+
+  // ~1% expected
+  BOOST_CHECK_LT(false_positives, 300);
+}
+
+BOOST_AUTO_TEST_CASE(empty_filter) {
+  KeyFilter filter(0, 10);
+  BOOST_CHECK(!filter.MayContain("a"));
+  BOOST_CHECK(!filter.MayContain(""));
+}
+
+BOOST_AUTO_TEST_CASE(write_and_read) {
+  boost::filesystem::path filename = boost::filesystem::temp_directory_path();
+  filename /= boost::filesystem::unique_path("key-filter-unit-test-%%%%-%%%%-%%%%-%%%%.kf");
+
+  KeyFilter filter(1000, 10);
+  for (size_t i = 0; i < 1000; ++i) {
+    filter.Add("key" + std::to_string(i));
+  }
+  filter.WriteToFile(filename.string());
+
+  std::shared_ptr<KeyFilter> loaded = KeyFilter::FromFile(filename.string());
+  BOOST_REQUIRE(loaded);
+  BOOST_CHECK_EQUAL(filter.SizeInBytes(), loaded->SizeInBytes());
+
+  for (size_t i = 0; i < 10000; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    BOOST_CHECK_EQUAL(filter.MayContain(key), loaded->MayContain(key));
+  }
+
+  // truncated file
+  boost::filesystem::resize_file(filename, boost::filesystem::file_size(filename) - 8);
+  BOOST_CHECK(!KeyFilter::FromFile(filename.string()));
+
+  // garbage
+  {
+    std::ofstream out_stream(filename.string(), std::ios::binary);
+    out_stream << "not a filter";
+  }
+  BOOST_CHECK(!KeyFilter::FromFile(filename.string()));
+
+  std::remove(filename.string().c_str());
+  BOOST_CHECK(!KeyFilter::FromFile(filename.string()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace util */
+} /* namespace dictionary */
+} /* namespace keyvi */
@@ -23,9 +23,14 @@
  *      Author: hendrik
  */
 
+#include <algorithm>
 #include <chrono>  //NOLINT
 #include <cstdlib>
+#include <memory>
+#include <string>
 #include <thread>  //NOLINT
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -371,6 +376,49 @@ BOOST_AUTO_TEST_CASE(index_delete_keys_simple_merge_policy) {
   index_with_deletes({{"refresh_interval", "100"}, {KEYVIMERGER_BIN, get_keyvimerger_bin()}, {MERGE_POLICY, "simple"}});
 }
 
+BOOST_AUTO_TEST_CASE(index_mdelete) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"}, {KEYVIMERGER_BIN, get_keyvimerger_bin()}});
+
+    for (int i = 0; i < 100; ++i) {
+      index.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+    }
+    index.Flush();
+
+    for (int i = 0; i < 100; ++i) {
+      index.Set("b" + std::to_string(i), "{\"id_b\":" + std::to_string(i) + "}");
+    }
+    index.Flush();
+
+    // keys in both segments and in the compiler, unsorted, duplicates and non-existing keys
+    index.Set("c1", "{}");
+    std::shared_ptr<std::vector<std::string>> keys = std::make_shared<std::vector<std::string>>(
+        std::initializer_list<std::string>{"b5", "a1", "a10", "a", "a1", "b50", "a100", "c1", "a11", "z", ""});
+    index.MDelete(keys);
+    index.Flush();
+
+    for (const std::string& key : std::vector<std::string>{"a1", "a10", "a11", "b5", "b50", "c1"}) {
+      BOOST_CHECK(!index.Contains(key));
+    }
+    for (const std::string& key : std::vector<std::string>{"a0", "a2", "a12", "a19", "a99", "b0", "b51", "b99"}) {
+      BOOST_CHECK(index.Contains(key));
+    }
+
+    // deletes survive a merge
+    index.ForceMerge();
+    BOOST_CHECK(!index.Contains("a10"));
+    BOOST_CHECK(!index.Contains("b50"));
+    BOOST_CHECK(index.Contains("a12"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
 BOOST_AUTO_TEST_CASE(segment_invalidation) {
   using boost::filesystem::temp_directory_path;
   using boost::filesystem::unique_path;
@@ -427,6 +475,369 @@ BOOST_AUTO_TEST_CASE(segment_invalidation) {
   boost::filesystem::remove_all(tmp_path);
 }
 
+BOOST_AUTO_TEST_CASE(index_generation) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"}});
+    size_t generation = index.Generation();
+
+    // nothing to flush
+    index.Flush();
+    BOOST_CHECK_EQUAL(generation, index.Generation());
+
+    index.Set("a", "{\"id\":3}");
+    BOOST_CHECK_EQUAL(generation, index.Generation());
+    index.Flush();
+    BOOST_CHECK_LT(generation, index.Generation());
+    generation = index.Generation();
+
+    index.Delete("a");
+    BOOST_CHECK_EQUAL(generation, index.Generation());
+    index.Flush();
+    BOOST_CHECK_LT(generation, index.Generation());
+    BOOST_CHECK(!index.Contains("a"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_key_filter) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"}, {KEYVIMERGER_BIN, get_keyvimerger_bin()}});
+
+    for (int i = 0; i < 10; ++i) {
+      index.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+      index.Flush();
+    }
+
+    internal::const_segments_t segments = unit_test::IndexFriend::GetSegments(&index);
+    for (const internal::segment_t& segment : *segments) {
+      BOOST_CHECK(boost::filesystem::exists(segment->GetDictionaryPath().string() + KEY_FILTER_FILE_SUFFIX));
+    }
+
+    BOOST_CHECK(!segments->back()->MayContain("a0"));
+    BOOST_CHECK(segments->front()->MayContain("a0"));
+
+    for (int i = 0; i < 10; ++i) {
+      BOOST_CHECK(index.Contains("a" + std::to_string(i)));
+      BOOST_CHECK_EQUAL("{\"id\":" + std::to_string(i) + "}", index["a" + std::to_string(i)].GetValueAsString());
+    }
+    BOOST_CHECK(!index.Contains("b"));
+
+    index.Delete("a3");
+    index.ForceMerge();
+    internal::const_segments_t merged_segments = unit_test::IndexFriend::GetSegments(&index);
+    BOOST_CHECK_EQUAL(1, merged_segments->size());
+    BOOST_CHECK(
+        boost::filesystem::exists(merged_segments->front()->GetDictionaryPath().string() + KEY_FILTER_FILE_SUFFIX));
+    BOOST_CHECK(!index.Contains("a3"));
+    BOOST_CHECK(index.Contains("a9"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_value_cache) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"}, {VALUE_CACHE_SIZE, "1048576"}});
+
+    index.Set("a", "{\"id\":3}");
+    index.Flush();
+    BOOST_CHECK_EQUAL("{\"id\":3}", index["a"].GetValueAsString());
+    // served from the cache
+    BOOST_CHECK_EQUAL("{\"id\":3}", index["a"].GetValueAsString());
+    BOOST_CHECK(index.Contains("a"));
+
+    // negative result
+    BOOST_CHECK(!index.Contains("b"));
+    index.Set("b", "{\"id\":4}");
+    index.Flush();
+    BOOST_CHECK(index.Contains("b"));
+
+    index.Set("a", "{\"id\":5}");
+    BOOST_CHECK_EQUAL("{\"id\":3}", index["a"].GetValueAsString());
+    index.Flush();
+    BOOST_CHECK_EQUAL("{\"id\":5}", index["a"].GetValueAsString());
+
+    index.Delete("a");
+    index.Flush();
+    BOOST_CHECK(index["a"].IsEmpty());
+    BOOST_CHECK(!index.Contains("a"));
+    BOOST_CHECK(index.Contains("b"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_write_order) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"}, {KEYVIMERGER_BIN, get_keyvimerger_bin()}});
+
+    // single key writes are batched, bulk writes are not, the order must still be kept
+    index.Set("a", "{\"v\":1}");
+    index.MSet(std::make_shared<std::vector<std::pair<std::string, std::string>>>(
+        std::initializer_list<std::pair<std::string, std::string>>{{"a", "{\"v\":2}"}, {"b", "{\"v\":2}"}}));
+    index.Set("b", "{\"v\":3}");
+    index.Delete("a");
+    index.Set("c", "{\"v\":4}");
+    index.MDelete(std::make_shared<std::vector<std::string>>(std::initializer_list<std::string>{"c"}));
+    index.Set("d", "{\"v\":5}");
+    index.Flush();
+
+    BOOST_CHECK(!index.Contains("a"));
+    BOOST_CHECK_EQUAL("{\"v\":3}", index["b"].GetValueAsString());
+    BOOST_CHECK(!index.Contains("c"));
+    BOOST_CHECK_EQUAL("{\"v\":5}", index["d"].GetValueAsString());
+
+    // concurrent writers
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+      writers.emplace_back([&index, t]() {
+        for (int i = 0; i < 1000; ++i) {
+          index.Set("t" + std::to_string(t) + "_" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+        }
+        index.Delete("t" + std::to_string(t) + "_0");
+      });
+    }
+    for (std::thread& writer : writers) {
+      writer.join();
+    }
+    index.Flush();
+
+    for (int t = 0; t < 4; ++t) {
+      BOOST_CHECK(!index.Contains("t" + std::to_string(t) + "_0"));
+      BOOST_CHECK_EQUAL("{\"id\":999}", index["t" + std::to_string(t) + "_999"].GetValueAsString());
+    }
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_tombstones) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"},
+                                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                    {TOMBSTONES_KEY, "true"},
+                                    {VALUE_CACHE_SIZE, "1048576"}});
+
+    for (int i = 0; i < 10; ++i) {
+      index.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+    }
+    index.Flush();
+    for (int i = 0; i < 10; ++i) {
+      index.Set("b" + std::to_string(i), "{\"id_b\":" + std::to_string(i) + "}");
+    }
+    index.Flush();
+    BOOST_CHECK(index.Contains("a1"));
+
+    index.Delete("a1");
+    index.MDelete(std::make_shared<std::vector<std::string>>(std::initializer_list<std::string>{"a2", "b3"}));
+    index.Flush();
+
+    // the deletes went into a new segment, older segments are untouched
+    internal::const_segments_t segments = unit_test::IndexFriend::GetSegments(&index);
+    BOOST_CHECK_EQUAL(3, segments->size());
+    for (const internal::segment_t& segment : *segments) {
+      BOOST_CHECK(!segment->HasDeletedKeys());
+    }
+    BOOST_REQUIRE(segments->back()->Tombstones());
+    BOOST_CHECK_EQUAL(3, segments->back()->Tombstones()->size());
+
+    BOOST_CHECK(!index.Contains("a1"));
+    BOOST_CHECK(!index.Contains("a2"));
+    BOOST_CHECK(!index.Contains("b3"));
+    BOOST_CHECK(index["a1"].IsEmpty());
+    BOOST_CHECK(index.Contains("a3"));
+    BOOST_CHECK(index.Contains("b2"));
+
+    // only one segment matches the prefix, the tombstones of the newer segment still apply
+    std::vector<std::string> matched_keys;
+    for (auto m : index.GetFuzzy("a1", 1, 1)) {
+      matched_keys.push_back(m.GetMatchedString());
+    }
+    std::vector<std::string> expected_keys{"a0", "a3", "a4", "a5", "a6", "a7", "a8", "a9"};
+    std::sort(matched_keys.begin(), matched_keys.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected_keys.begin(), expected_keys.end(), matched_keys.begin(),
+                                  matched_keys.end());
+
+    matched_keys.clear();
+    for (auto m : index.GetNear("b3", 1, true)) {
+      matched_keys.push_back(m.GetMatchedString());
+    }
+    BOOST_CHECK_EQUAL(9, matched_keys.size());
+    BOOST_CHECK(std::find(matched_keys.begin(), matched_keys.end(), "b3") == matched_keys.end());
+
+    // a newer segment supersedes the tombstone
+    index.Set("a1", "{\"id\":11}");
+    index.Flush();
+    BOOST_CHECK_EQUAL("{\"id\":11}", index["a1"].GetValueAsString());
+
+    // merging into the oldest segment drops the tombstones
+    index.ForceMerge();
+    internal::const_segments_t merged_segments = unit_test::IndexFriend::GetSegments(&index);
+    BOOST_CHECK_EQUAL(1, merged_segments->size());
+    BOOST_CHECK(!merged_segments->front()->Tombstones());
+    BOOST_CHECK(!boost::filesystem::exists(
+        internal::TombstonesFile::Filename(merged_segments->front()->GetDictionaryPath().string())));
+    BOOST_CHECK(index.Contains("a1"));
+    BOOST_CHECK(!index.Contains("a2"));
+    BOOST_CHECK(!index.Contains("b3"));
+    BOOST_CHECK(index.Contains("b4"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_value_store_types) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+
+  // raw bytes, not valid json
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"},
+                                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                    {VALUE_STORE_TYPE, "string"}});
+    index.Set("a", "some \"raw\" {bytes");
+    index.Flush();
+    index.MSet(std::make_shared<std::vector<std::pair<std::string, std::string>>>(
+        std::initializer_list<std::pair<std::string, std::string>>{{"a", "\xff\x01"}, {"b", ""}}));
+    index.Flush();
+    BOOST_CHECK_EQUAL("\xff\x01", index["a"].GetValueAsString());
+    BOOST_CHECK(index.Contains("b"));
+
+    index.ForceMerge();
+    BOOST_CHECK_EQUAL(1, unit_test::IndexFriend::GetSegments(&index)->size());
+    BOOST_CHECK_EQUAL("\xff\x01", index["a"].GetValueAsString());
+  }
+
+  // the type is persisted, reopening with another type fails
+  BOOST_CHECK_THROW(Index(tmp_path.string(), {{VALUE_STORE_TYPE, "int"}}), std::invalid_argument);
+  {
+    Index index(tmp_path.string(), {{VALUE_STORE_TYPE, "string"}});
+    BOOST_CHECK_EQUAL("\xff\x01", index["a"].GetValueAsString());
+  }
+  boost::filesystem::remove_all(tmp_path);
+
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"},
+                                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                    {VALUE_STORE_TYPE, "int"}});
+    index.Set("a", "42");
+    index.Set("b", "18446744073709551615");
+    index.Flush();
+    BOOST_CHECK_EQUAL("42", index["a"].GetValueAsString());
+    BOOST_CHECK_EQUAL("18446744073709551615", index["b"].GetValueAsString());
+
+    // invalid values are rejected by the caller, nothing gets written
+    BOOST_CHECK_THROW(index.Set("c", "{\"id\":3}"), std::invalid_argument);
+    BOOST_CHECK_THROW(index.Set("c", "-1"), std::invalid_argument);
+    BOOST_CHECK_THROW(index.Set("c", "18446744073709551616"), std::invalid_argument);
+    BOOST_CHECK_THROW(index.MSet(std::make_shared<std::vector<std::pair<std::string, std::string>>>(
+                          std::initializer_list<std::pair<std::string, std::string>>{{"c", "1"}, {"d", "x"}})),
+                      std::invalid_argument);
+    index.Flush();
+    BOOST_CHECK(!index.Contains("c"));
+    BOOST_CHECK(!index.Contains("d"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"},
+                                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                    {VALUE_STORE_TYPE, "key_only"}});
+    index.Set("a", "ignored");
+    index.Set("b", "");
+    index.Flush();
+    index.Delete("b");
+    index.Flush();
+    BOOST_CHECK(index.Contains("a"));
+    BOOST_CHECK(!index.Contains("b"));
+    BOOST_CHECK_EQUAL("", index["a"].GetValueAsString());
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(index_pipelined_compile) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index index(tmp_path.string(), {{"refresh_interval", "100000"},
+                                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                    {SEGMENT_COMPILE_KEY_THRESHOLD, "100"},
+                                    {MAX_CONCURRENT_COMPILES, "2"},
+                                    {VALUE_CACHE_SIZE, "1048576"}});
+
+    // many small segments compiled in the background, newer values must win regardless of compile order
+    for (int i = 0; i < 5000; ++i) {
+      index.Set("k" + std::to_string(i % 700), "{\"v\":" + std::to_string(i) + "}");
+    }
+    index.Flush();
+    for (int i = 0; i < 700; ++i) {
+      const int last_write = i < 100 ? 4900 + i : 4200 + i;
+      BOOST_CHECK_EQUAL("{\"v\":" + std::to_string(last_write) + "}", index["k" + std::to_string(i)].GetValueAsString());
+    }
+
+    // deletes while the segment holding the key is still compiling
+    for (int i = 0; i < 20; ++i) {
+      const std::string key_a = "a" + std::to_string(i);
+      const std::string key_b = "b" + std::to_string(i);
+      index.Set(key_a, "{\"id\":1}");
+      index.Set(key_b, "{\"id\":2}");
+      index.Flush(true);
+      index.Delete(key_a);
+      index.MDelete(std::make_shared<std::vector<std::string>>(std::initializer_list<std::string>{key_b}));
+    }
+    index.Set("c", "{\"id\":3}");
+    index.Flush();
+
+    for (int i = 0; i < 20; ++i) {
+      BOOST_CHECK(!index.Contains("a" + std::to_string(i)));
+      BOOST_CHECK(!index.Contains("b" + std::to_string(i)));
+    }
+    BOOST_CHECK(index.Contains("c"));
+  }
+
+  // all segments have been published before the index got closed
+  {
+    Index index(tmp_path.string());
+    BOOST_CHECK_EQUAL("{\"v\":4999}", index["k99"].GetValueAsString());
+    BOOST_CHECK(!index.Contains("a0"));
+    BOOST_CHECK(index.Contains("c"));
+  }
+
+  boost::filesystem::remove_all(tmp_path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace index
@@ -0,0 +1,149 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * deleted_key_set_test.cpp
+ *
+ *  Created on: Jul 7, 2021
+ *      Author: hendrik
+ */
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/index/internal/deleted_key_set.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+BOOST_AUTO_TEST_SUITE(DeletedKeySetTests)
+
+BOOST_AUTO_TEST_CASE(empty) {
+  DeletedKeySet deleted_keys;
+
+  BOOST_CHECK(deleted_keys.empty());
+  BOOST_CHECK_EQUAL(0, deleted_keys.size());
+  BOOST_CHECK_EQUAL(0, deleted_keys.count("a"));
+  BOOST_CHECK_EQUAL(0, deleted_keys.count(""));
+}
+
+BOOST_AUTO_TEST_CASE(count) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 1000; ++i) {
+    keys.push_back("key-" + std::to_string(i * 2));
+  }
+  // duplicates and an empty key
+  keys.push_back("key-0");
+  keys.push_back("");
+
+  DeletedKeySet deleted_keys(keys);
+  BOOST_CHECK(!deleted_keys.empty());
+  BOOST_CHECK_EQUAL(1001, deleted_keys.size());
+
+  for (size_t i = 0; i < 1000; ++i) {
+    BOOST_CHECK_EQUAL(1, deleted_keys.count("key-" + std::to_string(i * 2)));
+    BOOST_CHECK_EQUAL(0, deleted_keys.count("key-" + std::to_string(i * 2 + 1)));
+  }
+  BOOST_CHECK_EQUAL(1, deleted_keys.count(""));
+  BOOST_CHECK_EQUAL(0, deleted_keys.count("key-"));
+  BOOST_CHECK_EQUAL(0, deleted_keys.count("a"));
+  BOOST_CHECK_EQUAL(0, deleted_keys.count("z"));
+}
+
+BOOST_AUTO_TEST_CASE(iteration_order) {
+  DeletedKeySet deleted_keys(std::vector<std::string>{"cd", "abc", "abd", "ab", "b", "abc"});
+
+  std::vector<std::string> keys;
+  deleted_keys.ForEach([&keys](const std::string& key) { keys.push_back(key); });
+
+  std::vector<std::string> expected{"ab", "abc", "abd", "b", "cd"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), keys.begin(), keys.end());
+}
+
+BOOST_AUTO_TEST_CASE(union_with_keys) {
+  DeletedKeySet base(std::vector<std::string>{"b", "d", "f"});
+  DeletedKeySet merged(base, std::unordered_set<std::string>{"a", "d", "e", "g"});
+
+  std::vector<std::string> keys;
+  merged.ForEach([&keys](const std::string& key) { keys.push_back(key); });
+
+  std::vector<std::string> expected{"a", "b", "d", "e", "f", "g"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), keys.begin(), keys.end());
+  BOOST_CHECK_EQUAL(6, merged.size());
+  BOOST_CHECK_EQUAL(1, merged.count("e"));
+  BOOST_CHECK_EQUAL(0, merged.count("c"));
+}
+
+BOOST_AUTO_TEST_CASE(overlay) {
+  std::shared_ptr<const DeletedKeySet> base = std::make_shared<DeletedKeySet>(std::vector<std::string>{"a", "b"});
+
+  DeletedKeysOverlay deleted_keys;
+  deleted_keys.Reset(base);
+  BOOST_CHECK_EQUAL(2, deleted_keys.size());
+
+  deleted_keys.Insert("a");
+  deleted_keys.Insert("c");
+  deleted_keys.Insert("c");
+  BOOST_CHECK_EQUAL(3, deleted_keys.size());
+
+  DeletedKeysOverlay other;
+  other.Insert("d");
+  other.Insert("a");
+  deleted_keys.Insert(other);
+  BOOST_CHECK_EQUAL(4, deleted_keys.size());
+
+  const std::shared_ptr<const DeletedKeySet>& compacted = deleted_keys.Compact();
+  BOOST_CHECK_EQUAL(4, compacted->size());
+  BOOST_CHECK_EQUAL(1, compacted->count("d"));
+
+  // the base is immutable, readers that hold it do not see the new keys
+  BOOST_CHECK_EQUAL(2, base->size());
+  BOOST_CHECK_EQUAL(0, base->count("c"));
+
+  deleted_keys.clear();
+  BOOST_CHECK_EQUAL(0, deleted_keys.size());
+}
+
+BOOST_AUTO_TEST_CASE(memory_usage) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 10000; ++i) {
+    keys.push_back("http://www.example.com/some/path/to/document/" + std::to_string(i));
+  }
+
+  size_t raw_bytes = 0;
+  for (const std::string& key : keys) {
+    raw_bytes += key.size();
+  }
+
+  DeletedKeySet deleted_keys(keys);
+  BOOST_CHECK_EQUAL(10000, deleted_keys.size());
+
+  // shared prefixes are stored once per block, a hash set needs more than the raw key bytes
+  BOOST_CHECK_LT(deleted_keys.SizeInBytes(), raw_bytes / 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace internal
+}  // namespace index
+}  // namespace keyvi
@@ -23,6 +23,9 @@
  *      Author: hendrik
  */
 
+#include <stdexcept>
+#include <string>
+
 #include <boost/test/unit_test.hpp>
 
 #include "keyvi/index/internal/index_settings.h"
@@ -39,6 +42,42 @@ BOOST_AUTO_TEST_CASE(defaultkeyvimergerbin) {
   BOOST_CHECK_EQUAL(std::string("keyvimerger"), settings.GetKeyviMergerBin());
 }
 
+BOOST_AUTO_TEST_CASE(valuecachesize) {
+  IndexSettings default_settings({});
+  BOOST_CHECK_EQUAL(0, default_settings.GetValueCacheSize());
+
+  IndexSettings settings(keyvi::util::parameters_t{{"value_cache_size", "1048576"}});
+  BOOST_CHECK_EQUAL(1048576, settings.GetValueCacheSize());
+}
+
+BOOST_AUTO_TEST_CASE(maxconcurrentcompiles) {
+  IndexSettings default_settings({});
+  BOOST_CHECK_EQUAL(2, default_settings.GetMaxConcurrentCompiles());
+
+  IndexSettings settings(keyvi::util::parameters_t{{"max_concurrent_compiles", "4"}});
+  BOOST_CHECK_EQUAL(4, settings.GetMaxConcurrentCompiles());
+
+  // compiles can not be disabled
+  IndexSettings no_compiles(keyvi::util::parameters_t{{"max_concurrent_compiles", "0"}});
+  BOOST_CHECK_EQUAL(1, no_compiles.GetMaxConcurrentCompiles());
+}
+
+BOOST_AUTO_TEST_CASE(valuestoretype) {
+  IndexSettings default_settings({});
+  BOOST_CHECK_EQUAL("json", default_settings.GetValueStoreTypeName());
+  BOOST_CHECK(dictionary::fsa::internal::value_store_t::JSON == default_settings.GetValueStoreType());
+
+  IndexSettings settings(keyvi::util::parameters_t{{"value_store_type", "int"}});
+  BOOST_CHECK_EQUAL("int", settings.GetValueStoreTypeName());
+  BOOST_CHECK(dictionary::fsa::internal::value_store_t::INT == settings.GetValueStoreType());
+
+  BOOST_CHECK(dictionary::fsa::internal::value_store_t::STRING == IndexSettings::ParseValueStoreType("string"));
+  BOOST_CHECK(dictionary::fsa::internal::value_store_t::KEY_ONLY == IndexSettings::ParseValueStoreType("key_only"));
+
+  BOOST_CHECK_THROW(IndexSettings(keyvi::util::parameters_t{{"value_store_type", "completion"}}),
+                    std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace internal */
@@ -17,11 +17,15 @@
 //
 
 #include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include <msgpack.hpp>
 
+#include "keyvi/index/internal/deleted_keys_journal.h"
 #include "keyvi/index/internal/read_only_segment.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -117,6 +121,72 @@ BOOST_AUTO_TEST_CASE(deletedkeys_reload) {
   std::remove(filename.c_str());
 }
 
+BOOST_AUTO_TEST_CASE(deletedkeys_journal) {
+  std::vector<std::pair<std::string, std::string>> test_data{
+      {"abc", "{a:1}"}, {"abbc", "{b:2}"}, {"cde", "{c:2}"}, {"fgh", "{g:6}"}, {"tyc", "{o:2}"}};
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+
+  std::string filename{dictionary.GetFileName() + ".dk"};
+  std::string filename_journal{dictionary.GetFileName() + ".dkl"};
+
+  {
+    std::vector<std::string> deleted_keys{"abc"};
+    std::ofstream out_stream(filename, std::ios::binary);
+    msgpack::pack(out_stream, deleted_keys);
+  }
+  DeletedKeysJournal::Append(filename_journal, {"tyc"});
+
+  read_only_segment_t segment(new ReadOnlySegment(dictionary.GetFileName()));
+  BOOST_CHECK(segment->HasDeletedKeys());
+  BOOST_CHECK_EQUAL(2, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("abc"));
+  BOOST_CHECK(segment->IsDeleted("tyc"));
+
+  BOOST_CHECK(!segment->ReloadDeletedKeys());
+
+  // new keys are read from the journal
+  DeletedKeysJournal::Append(filename_journal, {"cde"});
+  BOOST_CHECK(segment->ReloadDeletedKeys());
+  BOOST_CHECK_EQUAL(3, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("cde"));
+
+  // an incomplete entry is picked up once it is complete
+  {
+    std::stringstream buffer;
+    msgpack::pack(buffer, std::string("fgh"));
+    const std::string entry = buffer.str();
+
+    std::ofstream out_stream(filename_journal, std::ios::binary | std::ios::app);
+    out_stream.write(entry.data(), entry.size() - 1);
+    out_stream.flush();
+    BOOST_CHECK(!segment->ReloadDeletedKeys());
+    BOOST_CHECK(!segment->IsDeleted("fgh"));
+
+    out_stream.write(entry.data() + entry.size() - 1, 1);
+  }
+  BOOST_CHECK(segment->ReloadDeletedKeys());
+  BOOST_CHECK(segment->IsDeleted("fgh"));
+
+  // compaction: full list first, then a journal with a new epoch
+  {
+    std::vector<std::string> deleted_keys{"abc", "cde", "fgh", "tyc"};
+    std::ofstream out_stream(filename, std::ios::binary);
+    msgpack::pack(out_stream, deleted_keys);
+  }
+  DeletedKeysJournal::Create(filename_journal);
+  BOOST_CHECK(!segment->ReloadDeletedKeys());
+  BOOST_CHECK_EQUAL(4, segment->DeletedKeysSize());
+
+  DeletedKeysJournal::Append(filename_journal, {"abbc"});
+  BOOST_CHECK(segment->ReloadDeletedKeys());
+  BOOST_CHECK_EQUAL(5, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("abbc"));
+  BOOST_CHECK(segment->IsDeleted("abc"));
+
+  std::remove(filename_journal.c_str());
+  std::remove(filename.c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace internal
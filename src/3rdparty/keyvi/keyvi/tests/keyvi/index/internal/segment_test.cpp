@@ -23,6 +23,7 @@
 
 #include <msgpack.hpp>
 
+#include "keyvi/index/internal/deleted_keys_journal.h"
 #include "keyvi/index/internal/segment.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -33,17 +34,29 @@ namespace internal {
 BOOST_AUTO_TEST_SUITE(SegmentTests)
 
 void LoadDeletedKeys(const std::string& filename, std::vector<std::string>* deleted_keys) {
+  deleted_keys->clear();
+
+  // keys that have not been compacted yet are in the journal
+  uint64_t journal_epoch = 0;
+  size_t journal_offset = 0;
+  const bool has_journal = DeletedKeysJournal::Tail(DeletedKeysJournal::JournalFilename(filename), &journal_epoch,
+                                                    &journal_offset, deleted_keys);
+
   std::ifstream deleted_keys_stream(filename, std::ios::binary);
 
-  BOOST_CHECK(deleted_keys_stream.good());
+  BOOST_CHECK(deleted_keys_stream.good() || has_journal);
 
-  std::stringstream buffer;
-  buffer << deleted_keys_stream.rdbuf();
+  if (deleted_keys_stream.good()) {
+    std::stringstream buffer;
+    buffer << deleted_keys_stream.rdbuf();
 
-  msgpack::object_handle unpacked_object;
-  msgpack::unpack(unpacked_object, buffer.str().data(), buffer.str().size());
+    msgpack::object_handle unpacked_object;
+    msgpack::unpack(unpacked_object, buffer.str().data(), buffer.str().size());
 
-  unpacked_object.get().convert(*deleted_keys);
+    std::vector<std::string> compacted_keys;
+    unpacked_object.get().convert(compacted_keys);
+    deleted_keys->insert(deleted_keys->end(), compacted_keys.begin(), compacted_keys.end());
+  }
   std::sort(deleted_keys->begin(), deleted_keys->end());
 }
 
@@ -105,6 +118,77 @@ BOOST_AUTO_TEST_CASE(deletekey) {
 
   segment->RemoveFiles();
   BOOST_CHECK(!boost::filesystem::exists(dictionary.GetFileName() + ".dk"));
+  BOOST_CHECK(!boost::filesystem::exists(dictionary.GetFileName() + ".dkl"));
+}
+
+BOOST_AUTO_TEST_CASE(deletekeyJournalCompaction) {
+  std::vector<std::pair<std::string, std::string>> test_data;
+  for (size_t i = 0; i < 5000; ++i) {
+    test_data.emplace_back("key-" + std::to_string(i), "{a:1}");
+  }
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+  const std::string journal_filename = dictionary.GetFileName() + ".dkl";
+
+  segment_t segment(new Segment(dictionary.GetFileName()));
+
+  // small batches of deletes get appended to the journal
+  for (size_t i = 0; i < 100; ++i) {
+    segment->DeleteKey("key-" + std::to_string(i));
+    BOOST_CHECK(segment->Persist());
+  }
+  BOOST_CHECK(!segment->Persist());
+  BOOST_CHECK(!boost::filesystem::exists(dictionary.GetFileName() + ".dk"));
+  BOOST_CHECK(boost::filesystem::exists(journal_filename));
+
+  std::vector<std::string> deleted_keys;
+  LoadDeletedKeys(dictionary.GetFileName() + ".dk", &deleted_keys);
+  BOOST_CHECK_EQUAL(100, deleted_keys.size());
+
+  // the journal gets compacted once it outgrows the deleted keys file
+  size_t max_journal_size = 0;
+  for (size_t i = 100; i < 5000; ++i) {
+    segment->DeleteKey("key-" + std::to_string(i));
+    segment->Persist();
+    max_journal_size = std::max(max_journal_size, static_cast<size_t>(boost::filesystem::file_size(journal_filename)));
+  }
+  BOOST_CHECK(boost::filesystem::exists(dictionary.GetFileName() + ".dk"));
+  BOOST_CHECK_LT(max_journal_size, boost::filesystem::file_size(dictionary.GetFileName() + ".dk"));
+
+  LoadDeletedKeys(dictionary.GetFileName() + ".dk", &deleted_keys);
+  BOOST_CHECK_EQUAL(5000, deleted_keys.size());
+
+  segment->ReloadDeletedKeys();
+  BOOST_CHECK_EQUAL(5000, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("key-4999"));
+
+  segment->RemoveFiles();
+  BOOST_CHECK(!boost::filesystem::exists(dictionary.GetFileName() + ".dk"));
+  BOOST_CHECK(!boost::filesystem::exists(journal_filename));
+}
+
+BOOST_AUTO_TEST_CASE(deletekeys) {
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"abc", "{a:1}"}, {"abbc", "{b:2}"}, {"abcd", "{c:2}"}, {"abcde", "{g:6}"}, {"b", "{o:2}"}, {"tyc", "{o:2}"}};
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+
+  segment_t segment(new Segment(dictionary.GetFileName()));
+
+  // sorted, with prefixes of each other and keys that are not in the dictionary
+  segment->DeleteKeys({"", "ab", "abbc", "abc", "abcdd", "abcde", "abcdef", "b", "ty", "tyd"});
+  segment->Persist();
+
+  std::vector<std::string> deleted_keys;
+  LoadDeletedKeys(dictionary.GetFileName() + ".dk", &deleted_keys);
+
+  std::vector<std::string> expected{"abbc", "abc", "abcde", "b"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), deleted_keys.begin(), deleted_keys.end());
+
+  segment->ReloadDeletedKeys();
+  BOOST_CHECK(segment->IsDeleted("abc"));
+  BOOST_CHECK(!segment->IsDeleted("abcd"));
+  BOOST_CHECK(!segment->IsDeleted("tyc"));
+
+  segment->RemoveFiles();
 }
 
 BOOST_AUTO_TEST_CASE(deletekeyDuringMerge) {
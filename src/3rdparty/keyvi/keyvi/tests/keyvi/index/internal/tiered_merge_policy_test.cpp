@@ -24,6 +24,8 @@
  */
 
 #include <memory>
+#include <string>
+#include <unordered_set>
 
 #include <boost/test/unit_test.hpp>
 
@@ -44,7 +46,10 @@ class SegmentFriend {
   }
 
   static void SetDeletedKeys(segment_t segment, std::unordered_set<std::string> keys) {
-    segment->deleted_keys_for_write_ = keys;
+    segment->deleted_keys_for_write_.clear();
+    for (const std::string& key : keys) {
+      segment->deleted_keys_for_write_.Insert(key);
+    }
     if (keys.size() > 0) {
       segment->deletes_loaded = true;
     }
@@ -0,0 +1,125 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * value_cache_test.cpp
+ *
+ *  Created on: Jun 23, 2021
+ *      Author: hendrik
+ */
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/match.h"
+#include "keyvi/index/internal/value_cache.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+BOOST_AUTO_TEST_SUITE(ValueCacheTests)
+
+dictionary::Match CreateMatch(const std::string& key, const std::string& raw_value) {
+  dictionary::Match match(0, key.size(), key, 7);
+  match.SetRawValue(raw_value);
+  return match;
+}
+
+BOOST_AUTO_TEST_CASE(get_and_put) {
+  ValueCache cache(1024 * 1024);
+  dictionary::Match match;
+  uint64_t epoch = 0;
+
+  BOOST_CHECK(!cache.Get("a", &match, &epoch));
+  cache.Put("a", epoch, CreateMatch("a", "value a"));
+
+  BOOST_CHECK(cache.Get("a", &match, &epoch));
+  BOOST_CHECK(!match.IsEmpty());
+  BOOST_CHECK_EQUAL("a", match.GetMatchedString());
+  BOOST_CHECK_EQUAL("value a", match.GetRawValueAsString());
+  BOOST_CHECK_EQUAL(7, match.GetScore());
+  BOOST_CHECK_LT(0, cache.Bytes());
+}
+
+BOOST_AUTO_TEST_CASE(negative_result) {
+  ValueCache cache(1024 * 1024);
+  dictionary::Match match = CreateMatch("b", "value b");
+  uint64_t epoch = 0;
+
+  BOOST_CHECK(!cache.Get("b", &match, &epoch));
+  cache.Put("b", epoch, dictionary::Match());
+
+  BOOST_CHECK(cache.Get("b", &match, &epoch));
+  BOOST_CHECK(match.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(invalidate) {
+  ValueCache cache(1024 * 1024);
+  dictionary::Match match;
+  uint64_t epoch = 0;
+
+  BOOST_CHECK(!cache.Get("a", &match, &epoch));
+  cache.Put("a", epoch, CreateMatch("a", "value a"));
+  cache.Invalidate("a");
+  BOOST_CHECK(!cache.Get("a", &match, &epoch));
+
+  // a lookup that raced with an invalidation must not be cached
+  const uint64_t stale_epoch = epoch;
+  cache.Invalidate("a");
+  cache.Put("a", stale_epoch, CreateMatch("a", "stale value"));
+  BOOST_CHECK(!cache.Get("a", &match, &epoch));
+
+  cache.Put("a", epoch, CreateMatch("a", "new value"));
+  BOOST_CHECK(cache.Get("a", &match, &epoch));
+  BOOST_CHECK_EQUAL("new value", match.GetRawValueAsString());
+
+  cache.Clear();
+  BOOST_CHECK(!cache.Get("a", &match, &epoch));
+  BOOST_CHECK_EQUAL(0, cache.Bytes());
+}
+
+BOOST_AUTO_TEST_CASE(eviction) {
+  // 16 shards with 1024 bytes each
+  ValueCache cache(16 * 1024);
+  dictionary::Match match;
+  uint64_t epoch = 0;
+
+  for (size_t i = 0; i < 1000; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    cache.Get(key, &match, &epoch);
+    cache.Put(key, epoch, CreateMatch(key, std::string(100, 'v')));
+  }
+
+  BOOST_CHECK_LE(cache.Bytes(), 16 * 1024);
+
+  // the last key is still in the cache
+  BOOST_CHECK(cache.Get("key999", &match, &epoch));
+
+  // entries bigger than a shard are not cached
+  cache.Get("big", &match, &epoch);
+  cache.Put("big", epoch, CreateMatch("big", std::string(2048, 'v')));
+  BOOST_CHECK(!cache.Get("big", &match, &epoch));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
@@ -0,0 +1,114 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * write_batch_test.cpp
+ *
+ *  Created on: Jul 26, 2021
+ *      Author: hendrik
+ */
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/index/internal/write_batch.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+BOOST_AUTO_TEST_SUITE(WriteBatchTests)
+
+using record_t = std::tuple<WriteBatch::Operation, std::string, std::string, int32_t>;
+
+std::vector<record_t> GetRecords(const WriteBatch& write_batch) {
+  std::vector<record_t> records;
+  write_batch.ForEach([&records](const WriteBatch::Operation operation, const std::string& key,
+                                 const std::string& value,
+                                 const int32_t hashcode) { records.emplace_back(operation, key, value, hashcode); });
+  return records;
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+  WriteBatch write_batch;
+
+  BOOST_CHECK(write_batch.empty());
+  BOOST_CHECK_EQUAL(0, write_batch.size());
+  BOOST_CHECK(GetRecords(write_batch).empty());
+}
+
+BOOST_AUTO_TEST_CASE(insertion_order) {
+  WriteBatch write_batch;
+  write_batch.Set("b", "{\"id\":1}");
+  write_batch.Delete("a");
+  write_batch.Set("a", "");
+  write_batch.Set("", "{}");
+  write_batch.Delete("b");
+
+  BOOST_CHECK_EQUAL(5, write_batch.size());
+
+  std::vector<record_t> records = GetRecords(write_batch);
+  BOOST_REQUIRE_EQUAL(5, records.size());
+  BOOST_CHECK(records[0] == record_t(WriteBatch::Operation::SET, "b", "{\"id\":1}", 0));
+  BOOST_CHECK(records[1] == record_t(WriteBatch::Operation::DELETE, "a", "", 0));
+  BOOST_CHECK(records[2] == record_t(WriteBatch::Operation::SET, "a", "", 0));
+  BOOST_CHECK(records[3] == record_t(WriteBatch::Operation::SET, "", "{}", 0));
+  BOOST_CHECK(records[4] == record_t(WriteBatch::Operation::DELETE, "b", "", 0));
+}
+
+BOOST_AUTO_TEST_CASE(encoded_values) {
+  WriteBatch write_batch;
+  write_batch.SetEncoded("a", std::string("\0\x81", 2), -42);
+  write_batch.Delete("a");
+  write_batch.SetEncoded("b", "", 0x7fffffff);
+
+  std::vector<record_t> records = GetRecords(write_batch);
+  BOOST_REQUIRE_EQUAL(3, records.size());
+  BOOST_CHECK(records[0] == record_t(WriteBatch::Operation::SET_ENCODED, "a", std::string("\0\x81", 2), -42));
+  BOOST_CHECK(records[1] == record_t(WriteBatch::Operation::DELETE, "a", "", 0));
+  BOOST_CHECK(records[2] == record_t(WriteBatch::Operation::SET_ENCODED, "b", "", 0x7fffffff));
+}
+
+BOOST_AUTO_TEST_CASE(long_records) {
+  // lengths that need more than 1 byte as varint and grow the arena
+  const std::string key(300, 'k');
+  const std::string value(100000, 'v');
+
+  WriteBatch write_batch;
+  for (size_t i = 0; i < 10; ++i) {
+    write_batch.Set(key + std::to_string(i), value);
+  }
+
+  std::vector<record_t> records = GetRecords(write_batch);
+  BOOST_REQUIRE_EQUAL(10, records.size());
+  for (size_t i = 0; i < 10; ++i) {
+    BOOST_CHECK_EQUAL(key + std::to_string(i), std::get<1>(records[i]));
+    BOOST_CHECK_EQUAL(value, std::get<2>(records[i]));
+  }
+  BOOST_CHECK_GE(write_batch.SizeInBytes(), 10 * (key.size() + value.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace internal
+}  // namespace index
+}  // namespace keyvi
@@ -147,6 +147,36 @@ BOOST_AUTO_TEST_CASE(indexwithdeletedkeys) {
   BOOST_CHECK(!reader.Contains("störe"));
 }
 
+BOOST_AUTO_TEST_CASE(indexwithdeletedkeys_value_cache) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"cdefg", "{t:1}"}, {"商店", "{a:1}"}, {"störe", "{b:2}"}};
+
+  index.AddSegment(&test_data);
+
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {{"商店", "{b:2}"}, {"babcde", "{a:1}"}};
+
+  index.AddSegment(&test_data_2);
+
+  ReadOnlyIndex reader(index.GetIndexFolder(), {{"refresh_interval", "600"}, {"value_cache_size", "1048576"}});
+
+  BOOST_CHECK_EQUAL(reader["商店"].GetValueAsString(), "\"{b:2}\"");
+  BOOST_CHECK_EQUAL(reader["商店"].GetValueAsString(), "\"{b:2}\"");
+  BOOST_CHECK(reader.Contains("störe"));
+  BOOST_CHECK(!reader.Contains("ab"));
+
+  index.AddDeletedKeys({"商店"}, 1);
+  reader.Reload();
+  BOOST_CHECK(!reader.Contains("商店"));
+  BOOST_CHECK(reader.Contains("störe"));
+
+  index.AddDeletedKeys({"störe"}, 0);
+  reader.Reload();
+  BOOST_CHECK(!reader.Contains("störe"));
+  BOOST_CHECK(reader.Contains("cdefg"));
+}
+
 void testFuzzyMatching(ReadOnlyIndex* reader, const std::string& query, const size_t max_edit_distance,
                        const size_t minimum_exact_prefix, const std::vector<std::string>& expected_matches,
                        const std::vector<std::string>& expected_values) {
@@ -16,13 +16,17 @@
  */
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
 #include "brpc/server.h"
 #include "butil/logging.h"
 
 #include "keyvi_server/core/data_backend.h"
+#include "keyvi_server/service/coordinator_impl.h"
 #include "keyvi_server/service/index_impl.h"
 #include "keyvi_server/service/redis/command_handler.h"
 #include "keyvi_server/service/redis/redis_service_impl.h"
@@ -57,11 +61,32 @@ int main(int argc, char** argv) {
                             "TCP Port of the builtin services");
   description.add_options()("redis,r", boost::program_options::bool_switch()->default_value(false),
                             "Whether to enable resp (redis protocol)");
+  description.add_options()("data-dir,d", boost::program_options::value<std::string>()->default_value("data"),
+                            "Directory of the index");
+  description.add_options()("shards", boost::program_options::value<std::string>()->default_value(""),
+                            "Comma separated list of shards (host:port), runs the server as coordinator");
+  description.add_options()("shard-timeout-ms", boost::program_options::value<int32_t>()->default_value(500),
+                            "Timeout in ms for the shards to answer, partial results are returned after it");
+  description.add_options()("result-cache-mb", boost::program_options::value<size_t>()->default_value(64),
+                            "Size of the cache for fuzzy and near results in MB, 0 disables the cache");
+  description.add_options()("value-cache-mb", boost::program_options::value<size_t>()->default_value(0),
+                            "Size of the cache for point lookups (get/exists) in MB, 0 disables the cache");
+  description.add_options()("tombstones", boost::program_options::bool_switch()->default_value(false),
+                            "Write deletes as tombstones into new segments instead of updating all older segments");
+  description.add_options()("value-store-type", boost::program_options::value<std::string>()->default_value("json"),
+                            "Value store of the index: json, string (raw bytes), int or key_only");
 
   boost::program_options::variables_map vm;
 
   int32_t port;
   int32_t internal_port;
+  std::string data_dir;
+  std::vector<std::string> shards;
+  int32_t shard_timeout_ms;
+  size_t result_cache_mb;
+  size_t value_cache_mb;
+  bool tombstones;
+  std::string value_store_type;
 
   try {
     boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(description).run(),
@@ -76,6 +101,26 @@ int main(int argc, char** argv) {
 
     internal_port = vm["internal-port"].as<int32_t>();
     port = vm["port"].as<int32_t>();
+    data_dir = vm["data-dir"].as<std::string>();
+    shard_timeout_ms = vm["shard-timeout-ms"].as<int32_t>();
+    result_cache_mb = vm["result-cache-mb"].as<size_t>();
+    value_cache_mb = vm["value-cache-mb"].as<size_t>();
+    tombstones = vm["tombstones"].as<bool>();
+    value_store_type = vm["value-store-type"].as<std::string>();
+
+    std::vector<std::string> shards_list;
+    boost::split(shards_list, vm["shards"].as<std::string>(), boost::is_any_of(","));
+    for (std::string& shard : shards_list) {
+      boost::trim(shard);
+      if (shard.empty()) {
+        continue;
+      }
+      if (shard.find(':') == std::string::npos) {
+        LOG(ERROR) << "invalid shard '" << shard << "', expected host:port";
+        return 1;
+      }
+      shards.push_back(shard);
+    }
   } catch (std::exception& e) {
     std::cout << "ERROR: arguments wrong or missing." << std::endl << std::endl;
 
@@ -87,16 +132,31 @@ int main(int argc, char** argv) {
   // Generally you only need one Server.
   brpc::Server server;
 
-  // data backend
-  keyvi_server::core::data_backend_t data_backend = std::make_shared<keyvi_server::core::DataBackend>("data");
+  // data backend, not used in coordinator mode
+  keyvi_server::core::data_backend_t data_backend;
 
   // Instance of your service.
-  keyvi_server::service::IndexImpl index_service_impl(data_backend);
+  std::unique_ptr<keyvi_server::service::Index> index_service_impl;
+
+  if (shards.empty()) {
+    data_backend = std::make_shared<keyvi_server::core::DataBackend>(data_dir, value_cache_mb * 1024 * 1024, tombstones,
+                                                                     value_store_type);
+    index_service_impl.reset(new keyvi_server::service::IndexImpl(data_backend, result_cache_mb * 1024 * 1024));
+  } else {
+    keyvi_server::service::CoordinatorImpl* coordinator_impl =
+        new keyvi_server::service::CoordinatorImpl(shards, shard_timeout_ms);
+    index_service_impl.reset(coordinator_impl);
+
+    if (coordinator_impl->Init() != 0) {
+      LOG(ERROR) << "Fail to connect to shards";
+      return -1;
+    }
+  }
 
   // Add the service into server. Notice the second parameter, because the
-  // service is put on stack, we don't want server to delete it, otherwise
+  // service is owned by main, we don't want server to delete it, otherwise
   // use brpc::SERVER_OWNS_SERVICE.
-  if (server.AddService(&index_service_impl, brpc::SERVER_DOESNT_OWN_SERVICE) != 0) {
+  if (server.AddService(index_service_impl.get(), brpc::SERVER_DOESNT_OWN_SERVICE) != 0) {
     LOG(ERROR) << "Fail to add service";
     return -1;
   }
@@ -114,6 +174,10 @@ int main(int argc, char** argv) {
 
   bool resp = vm.count("redis") ? vm["redis"].as<bool>() : false;
   if (resp) {
+    if (!data_backend) {
+      LOG(ERROR) << "resp is not supported in coordinator mode";
+      return -1;
+    }
     options.redis_service = createRedisService(data_backend);
   }
 
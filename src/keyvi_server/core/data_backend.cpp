@@ -29,8 +29,12 @@
 namespace keyvi_server {
 namespace core {
 
-DataBackend::DataBackend(const std::string& path)
-    : index_(path, {{KEYVIMERGER_BIN, util::ExecutableFinder::GetKeyviMergerBin()}}) {}
+DataBackend::DataBackend(const std::string& path, const size_t value_cache_bytes, const bool tombstones,
+                         const std::string& value_store_type)
+    : index_(path, {{KEYVIMERGER_BIN, util::ExecutableFinder::GetKeyviMergerBin()},
+                    {VALUE_CACHE_SIZE, std::to_string(value_cache_bytes)},
+                    {TOMBSTONES_KEY, tombstones ? "true" : "false"},
+                    {VALUE_STORE_TYPE, value_store_type}}) {}
 
 keyvi::index::Index& DataBackend::GetIndex() { return index_; }
 
@@ -35,7 +35,16 @@ namespace core {
 
 class DataBackend {
  public:
-  explicit DataBackend(const std::string& path);
+  /**
+   * Open the index at the given path.
+   *
+   * @param path the index directory
+   * @param value_cache_bytes size of the cache for point lookups in bytes, 0 disables the cache
+   * @param tombstones write deletes as tombstones into new segments instead of marking them in all older segments
+   * @param value_store_type value store of the index: json, string, int or key_only, must match an existing index
+   */
+  explicit DataBackend(const std::string& path, const size_t value_cache_bytes = 0, const bool tombstones = false,
+                       const std::string& value_store_type = DEFAULT_VALUE_STORE_TYPE);
 
   keyvi::index::Index& GetIndex();
 
@@ -0,0 +1,186 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * coordinator_impl.cpp
+ *
+ *  Created on: Jun 2, 2021
+ *      Author: hendrik
+ */
+
+#include "keyvi_server/service/coordinator_impl.h"
+
+#include <string>
+#include <vector>
+
+#include <brpc/channel.h>
+#include <brpc/closure_guard.h>
+#include <brpc/controller.h>
+#include <butil/logging.h>
+
+namespace keyvi_server {
+namespace service {
+
+namespace {
+
+/**
+ * Maps the sub calls to responses of type ShardMatches, which is wire compatible with the fuzzy and near responses.
+ */
+class ShardCallMapper : public brpc::CallMapper {
+ public:
+  brpc::SubCall Map(int channel_index, const google::protobuf::MethodDescriptor* method,
+                    const google::protobuf::Message* request, google::protobuf::Message* response) override {
+    return brpc::SubCall(method, request, new ShardMatches(), brpc::DELETE_RESPONSE);
+  }
+};
+
+/**
+ * Keeps the results of every shard as a separate run, so they can be k-way merged afterwards.
+ */
+class ShardResponseMerger : public brpc::ResponseMerger {
+ public:
+  Result Merge(google::protobuf::Message* response, const google::protobuf::Message* sub_response) override {
+    static_cast<ShardedMatches*>(response)->add_shards()->CopyFrom(*static_cast<const ShardMatches*>(sub_response));
+    return MERGED;
+  }
+};
+
+}  // namespace
+
+CoordinatorImpl::CoordinatorImpl(const std::vector<std::string>& shards, const int32_t timeout_ms)
+    : shards_(shards), timeout_ms_(timeout_ms) {}
+
+CoordinatorImpl::~CoordinatorImpl() {}
+
+int CoordinatorImpl::Init() {
+  brpc::ParallelChannelOptions parallel_channel_options;
+  parallel_channel_options.timeout_ms = timeout_ms_;
+  // only fail if all shards failed, return partial results otherwise
+  parallel_channel_options.fail_limit = shards_.size();
+
+  if (channel_.Init(&parallel_channel_options) != 0) {
+    LOG(ERROR) << "Fail to init parallel channel";
+    return -1;
+  }
+
+  brpc::ChannelOptions channel_options;
+  // retrying a slow shard does not help, the timeout is controlled by the parallel channel
+  channel_options.max_retry = 0;
+
+  ShardCallMapper* call_mapper = new ShardCallMapper();
+  ShardResponseMerger* response_merger = new ShardResponseMerger();
+
+  for (const std::string& shard : shards_) {
+    brpc::Channel* sub_channel = new brpc::Channel();
+    if (sub_channel->Init(shard.c_str(), &channel_options) != 0) {
+      LOG(ERROR) << "Fail to init channel to shard " << shard;
+      delete sub_channel;
+      return -1;
+    }
+
+    if (channel_.AddChannel(sub_channel, brpc::OWNS_CHANNEL, call_mapper, response_merger) != 0) {
+      LOG(ERROR) << "Fail to add channel to shard " << shard;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void CoordinatorImpl::Info(google::protobuf::RpcController* cntl_base, const InfoRequest* request,
+                           InfoResponse* response, google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+  brpc::Controller* cntl = static_cast<brpc::Controller*>(cntl_base);
+  (*response->mutable_info())["version"] = "0.0.1";
+  (*response->mutable_info())["mode"] = "coordinator";
+  (*response->mutable_info())["shards"] = std::to_string(shards_.size());
+}
+
+void CoordinatorImpl::GetFuzzy(google::protobuf::RpcController* cntl_base, const GetFuzzyRequest* request,
+                               GetFuzzyResponse* response, google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+  brpc::Controller* cntl = static_cast<brpc::Controller*>(cntl_base);
+
+  ShardedMatches sharded_matches;
+  bool partial = false;
+  if (!CallShards("GetFuzzy", request, &sharded_matches, cntl, &partial)) {
+    return;
+  }
+
+  MergeShards(MatchMerger::Order::ASCENDING_SCORE, request->max_results(), &sharded_matches,
+              response->mutable_matches());
+  response->set_partial(partial);
+}
+
+void CoordinatorImpl::GetNear(google::protobuf::RpcController* cntl_base, const GetNearRequest* request,
+                              GetNearResponse* response, google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+  brpc::Controller* cntl = static_cast<brpc::Controller*>(cntl_base);
+
+  ShardedMatches sharded_matches;
+  bool partial = false;
+  if (!CallShards("GetNear", request, &sharded_matches, cntl, &partial)) {
+    return;
+  }
+
+  MergeShards(MatchMerger::Order::DESCENDING_SCORE, request->max_results(), &sharded_matches,
+              response->mutable_matches());
+
+  // if not greedy, only the matches with the longest exact prefix over all shards are returned
+  if (!request->greedy() && response->matches_size() > 0) {
+    const double best_score = response->matches(0).score();
+    int i = 1;
+    while (i < response->matches_size() && response->matches(i).score() == best_score) {
+      ++i;
+    }
+    response->mutable_matches()->DeleteSubrange(i, response->matches_size() - i);
+  }
+  response->set_partial(partial);
+}
+
+bool CoordinatorImpl::CallShards(const std::string& method_name, const google::protobuf::Message* request,
+                                 ShardedMatches* sharded_matches, brpc::Controller* cntl, bool* partial) {
+  brpc::Controller shards_cntl;
+  channel_.CallMethod(Index::descriptor()->FindMethodByName(method_name), &shards_cntl, request, sharded_matches,
+                      NULL);
+
+  if (shards_cntl.Failed()) {
+    cntl->SetFailed(shards_cntl.ErrorCode(), "all shards failed: %s", shards_cntl.ErrorText().c_str());
+    return false;
+  }
+
+  // the merger only gets called for successful sub calls
+  *partial = sharded_matches->shards_size() < shards_cntl.sub_count();
+  return true;
+}
+
+void CoordinatorImpl::MergeShards(const MatchMerger::Order order, const size_t max_results,
+                                  ShardedMatches* sharded_matches, matches_t* matches) {
+  const MatchMerger merger(order);
+  std::vector<matches_t*> runs;
+
+  for (ShardMatches& shard_matches : *sharded_matches->mutable_shards()) {
+    // a shard without max_results returns the matches in traversal order
+    merger.Sort(shard_matches.mutable_matches(), max_results);
+    runs.push_back(shard_matches.mutable_matches());
+  }
+
+  merger.Merge(runs, matches, max_results);
+}
+
+}  // namespace service
+}  // namespace keyvi_server
@@ -0,0 +1,82 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * coordinator_impl.h
+ *
+ *  Created on: Jun 2, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_SERVER_SERVICE_COORDINATOR_IMPL_H_
+#define KEYVI_SERVER_SERVICE_COORDINATOR_IMPL_H_
+
+#include <string>
+#include <vector>
+
+#include <brpc/parallel_channel.h>
+
+#include "coordinator.pb.h"  //NOLINT
+#include "index.pb.h"        //NOLINT
+#include "keyvi_server/service/match_merger.h"
+
+namespace keyvi_server {
+namespace service {
+
+/**
+ * Coordinator for an index that is partitioned over several servers (shards).
+ *
+ * Fuzzy and near queries are scattered to all shards, the sorted results get merged. If a shard does not answer
+ * within the timeout, the results of the remaining shards are returned and the response is marked as partial.
+ * Methods that require the key to be routed to a single shard are not implemented.
+ */
+class CoordinatorImpl : public Index {
+ public:
+  CoordinatorImpl(const std::vector<std::string>& shards, const int32_t timeout_ms);
+  ~CoordinatorImpl();
+
+  /**
+   * Connect to the shards, returns 0 on success, -1 otherwise.
+   */
+  int Init();
+
+  void Info(google::protobuf::RpcController* cntl_base, const InfoRequest* request, InfoResponse* response,
+            google::protobuf::Closure* done);
+  void GetFuzzy(google::protobuf::RpcController* cntl_base, const GetFuzzyRequest* request, GetFuzzyResponse* response,
+                google::protobuf::Closure* done);
+  void GetNear(google::protobuf::RpcController* cntl_base, const GetNearRequest* request, GetNearResponse* response,
+               google::protobuf::Closure* done);
+
+ private:
+  std::vector<std::string> shards_;
+  int32_t timeout_ms_;
+  brpc::ParallelChannel channel_;
+
+  /**
+   * Call all shards, returns false if all shards failed.
+   */
+  bool CallShards(const std::string& method_name, const google::protobuf::Message* request,
+                  ShardedMatches* sharded_matches, brpc::Controller* cntl, bool* partial);
+
+  static void MergeShards(const MatchMerger::Order order, const size_t max_results, ShardedMatches* sharded_matches,
+                          matches_t* matches);
+};
+
+}  // namespace service
+}  // namespace keyvi_server
+
+#endif  // KEYVI_SERVER_SERVICE_COORDINATOR_IMPL_H_
@@ -25,19 +25,71 @@
 #include "keyvi_server/service/index_impl.h"
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 #include <brpc/closure_guard.h>
 #include <brpc/controller.h>
 #include <google/protobuf/map.h>
+#include <google/protobuf/repeated_field.h>
+
+#include "keyvi_server/service/match_merger.h"
 
 namespace keyvi_server {
 namespace service {
 
-IndexImpl::IndexImpl(const keyvi_server::core::data_backend_t &backend) : backend_(backend) {}
+IndexImpl::IndexImpl(const keyvi_server::core::data_backend_t &backend, const size_t result_cache_bytes)
+    : backend_(backend) {
+  if (result_cache_bytes > 0) {
+    result_cache_.reset(new util::ResultCache(result_cache_bytes));
+  }
+}
 
 IndexImpl::~IndexImpl() {}
 
+template <typename RequestT, typename ResponseT>
+void IndexImpl::Coalesce(const char method, const RequestT &request, ResponseT *response,
+                         const std::function<void(ResponseT *)> &func) {
+  // the generation must be read before the query reads the segments
+  const size_t generation = backend_->GetIndex().Generation();
+  std::string key(1, method);
+  request.AppendToString(&key);
+
+  if (result_cache_) {
+    util::ResultCache::value_t cached = result_cache_->Get(key, generation);
+    if (cached) {
+      response->ParseFromString(*cached);
+      return;
+    }
+  }
+
+  util::SingleFlight::result_t serialized;
+  auto execute = [response, &func]() { func(response); };
+  auto serialize = [response, &serialized]() {
+    if (!serialized) {
+      std::shared_ptr<std::string> s = std::make_shared<std::string>();
+      response->SerializeToString(s.get());
+      serialized = s;
+    }
+    return serialized;
+  };
+
+  util::SingleFlight::result_t result;
+  if (single_flight_.Do(std::to_string(generation) + ":" + key, execute, serialize, &result)) {
+    if (result_cache_) {
+      result_cache_->Put(key, generation, serialize());
+    }
+    return;
+  }
+
+  if (result) {
+    response->ParseFromString(*result);
+  } else {
+    // the in-flight call failed, try on our own
+    func(response);
+  }
+}
+
 void IndexImpl::Info(google::protobuf::RpcController *cntl_base, const InfoRequest *request, InfoResponse *response,
                      google::protobuf::Closure *done) {
   brpc::ClosureGuard done_guard(done);
@@ -53,6 +105,20 @@ void IndexImpl::Delete(google::protobuf::RpcController *cntl_base, const DeleteR
   backend_->GetIndex().Delete(request->key());
 }
 
+void IndexImpl::MDelete(google::protobuf::RpcController *cntl_base, const MDeleteRequest *request,
+                        EmptyBodyResponse *response, google::protobuf::Closure *done) {
+  brpc::ClosureGuard done_guard(done);
+  brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+  std::shared_ptr<google::protobuf::RepeatedPtrField<std::string>> keys =
+      std::make_shared<google::protobuf::RepeatedPtrField<std::string>>();
+
+  // hack: cast to remove const and use keys from request
+  MDeleteRequest *request_m = const_cast<MDeleteRequest *>(request);
+  request_m->mutable_keys()->Swap(keys.get());
+
+  backend_->GetIndex().MDelete(keys);
+}
+
 void IndexImpl::Contains(google::protobuf::RpcController *cntl_base, const ContainsRequest *request,
                          ContainsResponse *response, google::protobuf::Closure *done) {
   brpc::ClosureGuard done_guard(done);
@@ -76,13 +142,20 @@ void IndexImpl::GetFuzzy(google::protobuf::RpcController *cntl_base, const GetFu
   brpc::ClosureGuard done_guard(done);
   brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
 
-  auto matches =
-      backend_->GetIndex().GetFuzzy(request->key(), request->max_edit_distance(), request->min_exact_prefix());
-  for (auto m : matches) {
-    Match *match = response->add_matches();
-    match->set_matched_string(m.GetMatchedString());
-    match->set_value(m.GetValueAsString());
-  }
+  Coalesce<GetFuzzyRequest, GetFuzzyResponse>('f', *request, response, [this, request](GetFuzzyResponse *response) {
+    auto matches =
+        backend_->GetIndex().GetFuzzy(request->key(), request->max_edit_distance(), request->min_exact_prefix());
+    for (auto m : matches) {
+      Match *match = response->add_matches();
+      match->set_matched_string(m.GetMatchedString());
+      match->set_value(m.GetValueAsString());
+      match->set_score(m.GetScore());
+    }
+
+    if (request->max_results() > 0) {
+      MatchMerger(MatchMerger::Order::ASCENDING_SCORE).Sort(response->mutable_matches(), request->max_results());
+    }
+  });
 }
 
 void IndexImpl::GetNear(google::protobuf::RpcController *cntl_base, const GetNearRequest *request,
@@ -90,12 +163,19 @@ void IndexImpl::GetNear(google::protobuf::RpcController *cntl_base, const GetNea
   brpc::ClosureGuard done_guard(done);
   brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
 
-  auto matches = backend_->GetIndex().GetNear(request->key(), request->min_exact_prefix(), request->greedy());
-  for (auto m : matches) {
-    Match *match = response->add_matches();
-    match->set_matched_string(m.GetMatchedString());
-    match->set_value(m.GetValueAsString());
-  }
+  Coalesce<GetNearRequest, GetNearResponse>('n', *request, response, [this, request](GetNearResponse *response) {
+    auto matches = backend_->GetIndex().GetNear(request->key(), request->min_exact_prefix(), request->greedy());
+    for (auto m : matches) {
+      Match *match = response->add_matches();
+      match->set_matched_string(m.GetMatchedString());
+      match->set_value(m.GetValueAsString());
+      match->set_score(m.GetScore());
+    }
+
+    if (request->max_results() > 0) {
+      MatchMerger(MatchMerger::Order::DESCENDING_SCORE).Sort(response->mutable_matches(), request->max_results());
+    }
+  });
 }
 
 void IndexImpl::GetRaw(google::protobuf::RpcController *cntl_base, const GetRawRequest *request,
@@ -113,7 +193,11 @@ void IndexImpl::Set(google::protobuf::RpcController *cntl_base, const SetRequest
   brpc::ClosureGuard done_guard(done);
   brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
 
-  backend_->GetIndex().Set(request->key(), request->value());
+  try {
+    backend_->GetIndex().Set(request->key(), request->value());
+  } catch (const std::invalid_argument &e) {
+    cntl->SetFailed(brpc::EREQUEST, "%s", e.what());
+  }
 }
 
 void IndexImpl::MSet(google::protobuf::RpcController *cntl_base, const MSetRequest *request,
@@ -127,7 +211,11 @@ void IndexImpl::MSet(google::protobuf::RpcController *cntl_base, const MSetReque
   MSetRequest *request_m = const_cast<MSetRequest *>(request);
   (*request_m->mutable_key_values()).swap(*key_values.get());
 
-  backend_->GetIndex().MSet(key_values);
+  try {
+    backend_->GetIndex().MSet(key_values);
+  } catch (const std::invalid_argument &e) {
+    cntl->SetFailed(brpc::EREQUEST, "%s", e.what());
+  }
 }
 
 void IndexImpl::Flush(google::protobuf::RpcController *cntl_base, const FlushRequest *request,
@@ -25,23 +25,33 @@
 #ifndef KEYVI_SERVER_SERVICE_INDEX_IMPL_H_
 #define KEYVI_SERVER_SERVICE_INDEX_IMPL_H_
 
+#include <functional>
+#include <memory>
 #include <string>
 
 #include <keyvi/index/index.h>
 
 #include "index.pb.h"  //NOLINT
 #include "keyvi_server/core/data_backend.h"
+#include "keyvi_server/util/result_cache.h"
+#include "keyvi_server/util/single_flight.h"
 
 namespace keyvi_server {
 namespace service {
 
 class IndexImpl : public Index {
  public:
-  explicit IndexImpl(const keyvi_server::core::data_backend_t& backend);
+  /**
+   * @param backend the data backend
+   * @param result_cache_bytes size of the cache for fuzzy and near results, 0 disables the cache
+   */
+  explicit IndexImpl(const keyvi_server::core::data_backend_t& backend, const size_t result_cache_bytes = 0);
   ~IndexImpl();
 
   void Delete(google::protobuf::RpcController* cntl_base, const DeleteRequest* request, EmptyBodyResponse* response,
               google::protobuf::Closure* done);
+  void MDelete(google::protobuf::RpcController* cntl_base, const MDeleteRequest* request, EmptyBodyResponse* response,
+               google::protobuf::Closure* done);
   void Contains(google::protobuf::RpcController* cntl_base, const ContainsRequest* request, ContainsResponse* response,
                 google::protobuf::Closure* done);
   void Info(google::protobuf::RpcController* cntl_base, const InfoRequest* request, InfoResponse* response,
@@ -65,6 +75,16 @@ class IndexImpl : public Index {
 
  private:
   keyvi_server::core::data_backend_t backend_;
+  util::SingleFlight single_flight_;
+  std::unique_ptr<util::ResultCache> result_cache_;
+
+  /**
+   * Run func for the request, unless the result for the current index generation is cached. Identical concurrent
+   * requests against the same index generation share one execution.
+   */
+  template <typename RequestT, typename ResponseT>
+  void Coalesce(const char method, const RequestT& request, ResponseT* response,
+                const std::function<void(ResponseT*)>& func);
 };
 }  // namespace service
 }  // namespace keyvi_server
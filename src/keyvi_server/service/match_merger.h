@@ -0,0 +1,120 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * match_merger.h
+ *
+ *  Created on: Jun 2, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_SERVER_SERVICE_MATCH_MERGER_H_
+#define KEYVI_SERVER_SERVICE_MATCH_MERGER_H_
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h>
+
+#include "match.pb.h"  //NOLINT
+
+namespace keyvi_server {
+namespace service {
+
+using matches_t = google::protobuf::RepeatedPtrField<Match>;
+
+/**
+ * Sorts and merges matches, used to limit the number of results and to merge the results of several shards.
+ *
+ * Fuzzy matches are ordered by ascending score (edit distance), near matches by descending score (length of the
+ * exact matched prefix), ties are broken by the matched string.
+ */
+class MatchMerger final {
+ public:
+  enum class Order { ASCENDING_SCORE, DESCENDING_SCORE };
+
+  explicit MatchMerger(const Order order) : order_(order) {}
+
+  /**
+   * Returns true if lhs must be returned before rhs
+   */
+  bool operator()(const Match& lhs, const Match& rhs) const {
+    if (lhs.score() != rhs.score()) {
+      return order_ == Order::ASCENDING_SCORE ? lhs.score() < rhs.score() : lhs.score() > rhs.score();
+    }
+    return lhs.matched_string() < rhs.matched_string();
+  }
+
+  /**
+   * Sort the matches and truncate them to max_results (0 means no limit)
+   */
+  void Sort(matches_t* matches, const size_t max_results = 0) const {
+    auto less = [this](const Match* lhs, const Match* rhs) { return (*this)(*lhs, *rhs); };
+
+    if (max_results > 0 && static_cast<size_t>(matches->size()) > max_results) {
+      std::partial_sort(matches->pointer_begin(), matches->pointer_begin() + max_results, matches->pointer_end(),
+                        less);
+      matches->DeleteSubrange(max_results, matches->size() - max_results);
+    } else {
+      std::sort(matches->pointer_begin(), matches->pointer_end(), less);
+    }
+  }
+
+  /**
+   * k-way merge of sorted runs into output, the runs are consumed.
+   *
+   * Duplicates, e.g. the same key on several shards, are only returned once.
+   */
+  void Merge(const std::vector<matches_t*>& runs, matches_t* output, const size_t max_results = 0) const {
+    // heap entries: run index, position in run
+    using cursor_t = std::pair<size_t, int>;
+    auto greater = [this, &runs](const cursor_t& lhs, const cursor_t& rhs) {
+      return (*this)(runs[rhs.first]->Get(rhs.second), runs[lhs.first]->Get(lhs.second));
+    };
+    std::priority_queue<cursor_t, std::vector<cursor_t>, decltype(greater)> heap(greater);
+
+    for (size_t i = 0; i < runs.size(); ++i) {
+      if (runs[i]->size() > 0) {
+        heap.emplace(i, 0);
+      }
+    }
+
+    while (!heap.empty() && (max_results == 0 || static_cast<size_t>(output->size()) < max_results)) {
+      cursor_t top = heap.top();
+      heap.pop();
+
+      Match* match = runs[top.first]->Mutable(top.second);
+      if (output->size() == 0 || output->Get(output->size() - 1).matched_string() != match->matched_string()) {
+        output->Add()->Swap(match);
+      }
+
+      if (++top.second < runs[top.first]->size()) {
+        heap.push(top);
+      }
+    }
+  }
+
+ private:
+  Order order_;
+};
+
+}  // namespace service
+}  // namespace keyvi_server
+
+#endif  // KEYVI_SERVER_SERVICE_MATCH_MERGER_H_
@@ -77,7 +77,10 @@ class CommandHandler {
       }
       const std::string key(args[1].data(), args[1].size());
       const std::string value(args[2].data(), args[2].size());
-      redis_service_impl_->Set(key, value);
+      if (!redis_service_impl_->Set(key, value)) {
+        output->SetError("ERR value not supported by the value store of the index");
+        return brpc::REDIS_CMD_HANDLED;
+      }
       output->SetStatus("OK");
       return brpc::REDIS_CMD_HANDLED;
     }
@@ -108,7 +111,10 @@ class CommandHandler {
         i += 2;
       }
 
-      redis_service_impl_->MSet(key_values);
+      if (!redis_service_impl_->MSet(key_values)) {
+        output->SetError("ERR value not supported by the value store of the index");
+        return brpc::REDIS_CMD_HANDLED;
+      }
       output->SetStatus("OK");
       return brpc::REDIS_CMD_HANDLED;
     }
@@ -143,13 +149,21 @@ class CommandHandler {
         return brpc::REDIS_CMD_HANDLED;
       }
 
-      int64_t deletes = 0;
+      if (args.size() == 2ul) {
+        redis_service_impl_->Delete(args[1].as_string());
+        output->SetInteger(1);
+        return brpc::REDIS_CMD_HANDLED;
+      }
+
+      // multiple keys are deleted in 1 batch, as delete works async the keys have to be copied
+      std::shared_ptr<std::vector<std::string>> keys = std::make_shared<std::vector<std::string>>();
+      keys->reserve(args.size() - 1);
       for (size_t i = 1; i < args.size(); ++i) {
-        redis_service_impl_->Delete(args[i].as_string());
-        ++deletes;
+        keys->push_back(args[i].as_string());
       }
 
-      output->SetInteger(deletes);
+      redis_service_impl_->MDelete(keys);
+      output->SetInteger(keys->size());
       return brpc::REDIS_CMD_HANDLED;
     }
 
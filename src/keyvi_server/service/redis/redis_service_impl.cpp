@@ -24,6 +24,8 @@
 
 #include "keyvi_server/service/redis/redis_service_impl.h"
 
+#include <stdexcept>
+
 namespace keyvi_server {
 namespace service {
 namespace redis {
@@ -35,10 +37,20 @@ bool RedisServiceImpl::Delete(const std::string& key) {
   return true;
 }
 
+bool RedisServiceImpl::MDelete(const std::shared_ptr<std::vector<std::string>>& keys) {
+  backend_->GetIndex().MDelete(keys);
+  return true;
+}
+
 bool RedisServiceImpl::Exists(const std::string& key) { return backend_->GetIndex().Contains(key); }
 
 bool RedisServiceImpl::Set(const std::string& key, const std::string& value) {
-  backend_->GetIndex().Set(key, value);
+  try {
+    backend_->GetIndex().Set(key, value);
+  } catch (const std::invalid_argument&) {
+    // the value does not fit the value store of the index
+    return false;
+  }
   return true;
 }
 
@@ -63,7 +75,11 @@ bool RedisServiceImpl::Dump(const std::string& key, std::string* value) {
 }
 
 bool RedisServiceImpl::MSet(const std::shared_ptr<std::map<std::string, std::string>>& key_values) {
-  backend_->GetIndex().MSet(key_values);
+  try {
+    backend_->GetIndex().MSet(key_values);
+  } catch (const std::invalid_argument&) {
+    return false;
+  }
   return true;
 }
 
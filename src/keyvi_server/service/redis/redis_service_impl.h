@@ -28,6 +28,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "brpc/redis.h"
 
@@ -43,6 +44,8 @@ class RedisServiceImpl : public brpc::RedisService {
 
   bool Delete(const std::string& key);
 
+  bool MDelete(const std::shared_ptr<std::vector<std::string>>& keys);
+
   bool Exists(const std::string& key);
 
   bool Set(const std::string& key, const std::string& value);
@@ -0,0 +1,202 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * result_cache.h
+ *
+ *  Created on: Jun 16, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_SERVER_UTIL_RESULT_CACHE_H_
+#define KEYVI_SERVER_UTIL_RESULT_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>  //NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <bthread/mutex.h>
+#include <bvar/bvar.h>
+
+namespace keyvi_server {
+namespace util {
+
+/**
+ * Bounded cache for serialized query results, sharded by key, every shard is a LRU list.
+ *
+ * Entries are tagged with the index generation they have been computed for. A shard that sees a newer generation
+ * drops all its entries, results computed for an older generation are neither returned nor stored. That way results
+ * never outlive a segment swap or persisted deletes, no TTL required.
+ *
+ * Hits, misses, hit ratio, number of entries and memory usage are exposed as bvars with the given prefix.
+ */
+class ResultCache final {
+ public:
+  using value_t = std::shared_ptr<const std::string>;
+
+  explicit ResultCache(const size_t capacity_bytes, const std::string& metrics_prefix = "keyvi_server_result_cache")
+      : hits_(metrics_prefix, "hits"),
+        misses_(metrics_prefix, "misses"),
+        entries_(metrics_prefix, "entries"),
+        bytes_(metrics_prefix, "bytes"),
+        hit_ratio_(metrics_prefix, "hit_ratio", &ResultCache::HitRatio, this) {
+    for (Shard& shard : shards_) {
+      shard.capacity_bytes_ = capacity_bytes / kNumberOfShards;
+    }
+  }
+
+  ResultCache& operator=(ResultCache const&) = delete;
+  ResultCache(const ResultCache& that) = delete;
+
+  /**
+   * Get the result for the key, returns nullptr if not found or if the result belongs to another generation.
+   */
+  value_t Get(const std::string& key, const size_t generation) {
+    Shard& shard = GetShard(key);
+    std::unique_lock<bthread::Mutex> lock(shard.mutex_);
+
+    if (!UpdateGeneration(&shard, generation)) {
+      misses_ << 1;
+      return value_t();
+    }
+
+    auto it = shard.index_.find(key);
+    if (it == shard.index_.end()) {
+      misses_ << 1;
+      return value_t();
+    }
+
+    // move to the front of the LRU list
+    shard.entries_.splice(shard.entries_.begin(), shard.entries_, it->second);
+    hits_ << 1;
+    return it->second->value_;
+  }
+
+  /**
+   * Put the result for the key, evicts the least recently used entries if the shard is full.
+   */
+  void Put(const std::string& key, const size_t generation, const value_t& value) {
+    const size_t bytes = EntryBytes(key, value);
+    Shard& shard = GetShard(key);
+    std::unique_lock<bthread::Mutex> lock(shard.mutex_);
+
+    if (bytes > shard.capacity_bytes_ || !UpdateGeneration(&shard, generation)) {
+      return;
+    }
+
+    auto it = shard.index_.find(key);
+    if (it != shard.index_.end()) {
+      Erase(&shard, it->second);
+    }
+
+    shard.entries_.emplace_front(key, value, bytes);
+    shard.index_.emplace(key, shard.entries_.begin());
+    shard.bytes_ += bytes;
+    bytes_ << bytes;
+    entries_ << 1;
+
+    while (shard.bytes_ > shard.capacity_bytes_) {
+      Erase(&shard, std::prev(shard.entries_.end()));
+    }
+  }
+
+  size_t Bytes() const { return bytes_.get_value(); }
+
+  size_t Entries() const { return entries_.get_value(); }
+
+ private:
+  static const size_t kNumberOfShards = 16;
+
+  // rough estimate of the bookkeeping cost per entry: list node, hash node and the copy of the key in the index
+  static const size_t kEntryOverhead = 96;
+
+  struct Entry {
+    Entry(const std::string& key, const value_t& value, const size_t bytes) : key_(key), value_(value), bytes_(bytes) {}
+
+    std::string key_;
+    value_t value_;
+    size_t bytes_;
+  };
+
+  using entries_t = std::list<Entry>;
+
+  struct Shard {
+    Shard() : generation_(0), bytes_(0), capacity_bytes_(0) {}
+
+    bthread::Mutex mutex_;
+    size_t generation_;
+    size_t bytes_;
+    size_t capacity_bytes_;
+    entries_t entries_;
+    std::unordered_map<std::string, entries_t::iterator> index_;
+  };
+
+  Shard shards_[kNumberOfShards];
+  bvar::Adder<int64_t> hits_;
+  bvar::Adder<int64_t> misses_;
+  bvar::Adder<int64_t> entries_;
+  bvar::Adder<int64_t> bytes_;
+  bvar::PassiveStatus<double> hit_ratio_;
+
+  Shard& GetShard(const std::string& key) { return shards_[std::hash<std::string>()(key) % kNumberOfShards]; }
+
+  static size_t EntryBytes(const std::string& key, const value_t& value) {
+    return 2 * key.size() + value->size() + kEntryOverhead;
+  }
+
+  /**
+   * Drop all entries if the generation is newer, returns false if the generation is older than the one of the shard.
+   */
+  bool UpdateGeneration(Shard* shard, const size_t generation) {
+    if (generation < shard->generation_) {
+      return false;
+    }
+
+    if (generation > shard->generation_) {
+      bytes_ << -static_cast<int64_t>(shard->bytes_);
+      entries_ << -static_cast<int64_t>(shard->entries_.size());
+      shard->entries_.clear();
+      shard->index_.clear();
+      shard->bytes_ = 0;
+      shard->generation_ = generation;
+    }
+    return true;
+  }
+
+  void Erase(Shard* shard, entries_t::iterator entry) {
+    shard->bytes_ -= entry->bytes_;
+    bytes_ << -static_cast<int64_t>(entry->bytes_);
+    entries_ << -1;
+    shard->index_.erase(entry->key_);
+    shard->entries_.erase(entry);
+  }
+
+  static double HitRatio(void* arg) {
+    const ResultCache* cache = static_cast<const ResultCache*>(arg);
+    const int64_t hits = cache->hits_.get_value();
+    const int64_t lookups = hits + cache->misses_.get_value();
+    return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+  }
+};
+
+}  // namespace util
+}  // namespace keyvi_server
+
+#endif  // KEYVI_SERVER_UTIL_RESULT_CACHE_H_
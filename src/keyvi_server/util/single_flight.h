@@ -0,0 +1,146 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * single_flight.h
+ *
+ *  Created on: Jun 9, 2021
+ *      Author: hendrik
+ */
+
+#ifndef KEYVI_SERVER_UTIL_SINGLE_FLIGHT_H_
+#define KEYVI_SERVER_UTIL_SINGLE_FLIGHT_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  //NOLINT
+#include <string>
+#include <unordered_map>
+
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+
+namespace keyvi_server {
+namespace util {
+
+/**
+ * Coalesces identical concurrent calls: the first caller for a key executes the call, callers arriving while it is
+ * in flight wait for it and share the serialized result.
+ *
+ * The result only gets serialized if someone waits for it. Calls are spread over shards by key, so unrelated keys
+ * do not contend on the same lock. Uses bthread primitives, so waiting does not block the worker pthreads of the
+ * server.
+ */
+class SingleFlight final {
+ public:
+  using result_t = std::shared_ptr<const std::string>;
+
+  SingleFlight() {}
+
+  SingleFlight& operator=(SingleFlight const&) = delete;
+  SingleFlight(const SingleFlight& that) = delete;
+
+  /**
+   * Execute the call or wait for an in-flight call with the same key.
+   *
+   * @param key the key, must contain everything the result depends on
+   * @param execute the call
+   * @param serialize serializes the result of execute, only called if others wait for the result
+   * @param result the shared result if this caller did not execute the call, nullptr if the in-flight call failed, in
+   * which case the caller should execute the call itself
+   * @return true if execute has been called by this caller
+   */
+  bool Do(const std::string& key, const std::function<void()>& execute, const std::function<result_t()>& serialize,
+          result_t* result) {
+    Shard& shard = shards_[std::hash<std::string>()(key) % kNumberOfShards];
+    std::shared_ptr<Call> call;
+    {
+      std::unique_lock<bthread::Mutex> lock(shard.mutex_);
+      auto it = shard.calls_.find(key);
+      if (it != shard.calls_.end()) {
+        call = it->second;
+        ++call->waiters_;
+        while (!call->done_) {
+          call->condition_.wait(lock);
+        }
+        *result = call->result_;
+        return false;
+      }
+
+      call = std::make_shared<Call>();
+      shard.calls_.emplace(key, call);
+    }
+
+    try {
+      execute();
+    } catch (...) {
+      Finish(&shard, key, call, std::function<result_t()>());
+      throw;
+    }
+    Finish(&shard, key, call, serialize);
+    return true;
+  }
+
+ private:
+  static const size_t kNumberOfShards = 32;
+
+  struct Call {
+    Call() : done_(false), waiters_(0) {}
+
+    bool done_;
+    size_t waiters_;
+    result_t result_;
+    bthread::ConditionVariable condition_;
+  };
+
+  struct Shard {
+    bthread::Mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Call>> calls_;
+  };
+
+  Shard shards_[kNumberOfShards];
+
+  static void Finish(Shard* shard, const std::string& key, const std::shared_ptr<Call>& call,
+                     const std::function<result_t()>& serialize) {
+    size_t waiters = 0;
+    {
+      // remove the call, from now on nobody can join it, callers start a new flight instead
+      std::unique_lock<bthread::Mutex> lock(shard->mutex_);
+      shard->calls_.erase(key);
+      waiters = call->waiters_;
+    }
+
+    result_t result;
+    if (waiters > 0 && serialize) {
+      try {
+        result = serialize();
+      } catch (...) {
+        // waiters execute the call on their own
+      }
+    }
+
+    std::unique_lock<bthread::Mutex> lock(shard->mutex_);
+    call->result_ = result;
+    call->done_ = true;
+    call->condition_.notify_all();
+  }
+};
+
+}  // namespace util
+}  // namespace keyvi_server
+
+#endif  // KEYVI_SERVER_UTIL_SINGLE_FLIGHT_H_
@@ -0,0 +1,128 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * index_impl_test.cpp
+ *
+ *  Created on: Jun 9, 2021
+ *      Author: hendrik
+ */
+
+#include <memory>
+#include <string>
+#include <thread>  //NOLINT
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <brpc/controller.h>
+
+#include "keyvi_server/core/data_backend.h"
+#include "keyvi_server/service/index_impl.h"
+
+namespace keyvi_server {
+namespace service {
+
+BOOST_AUTO_TEST_SUITE(IndexImplTests)
+
+class TemporaryIndex {
+ public:
+  TemporaryIndex() : path_(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    backend_ = std::make_shared<core::DataBackend>(path_.string());
+  }
+
+  ~TemporaryIndex() {
+    backend_.reset();
+    boost::filesystem::remove_all(path_);
+  }
+
+  const core::data_backend_t& Backend() const { return backend_; }
+
+ private:
+  boost::filesystem::path path_;
+  core::data_backend_t backend_;
+};
+
+std::string fuzzy(IndexImpl* index, const std::string& key) {
+  brpc::Controller cntl;
+  GetFuzzyRequest request;
+  GetFuzzyResponse response;
+  request.set_key(key);
+  request.set_max_edit_distance(1);
+  index->GetFuzzy(&cntl, &request, &response, nullptr);
+  BOOST_CHECK(!cntl.Failed());
+
+  std::string matches;
+  for (const Match& match : response.matches()) {
+    matches += match.matched_string() + "=" + match.value() + ";";
+  }
+  return matches;
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_identical_requests) {
+  TemporaryIndex temporary_index;
+  IndexImpl index(temporary_index.Backend());
+
+  for (int i = 0; i < 1000; ++i) {
+    temporary_index.Backend()->GetIndex().Set("abc" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+  }
+  temporary_index.Backend()->GetIndex().Flush();
+
+  const std::string expected = fuzzy(&index, "abc10");
+  BOOST_CHECK(!expected.empty());
+
+  std::vector<std::string> results(16);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&index, &results, i]() { results[i] = fuzzy(&index, "abc10"); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (const std::string& result : results) {
+    BOOST_CHECK_EQUAL(expected, result);
+  }
+}
+
+void new_generation_test(const size_t result_cache_bytes) {
+  TemporaryIndex temporary_index;
+  IndexImpl index(temporary_index.Backend(), result_cache_bytes);
+
+  temporary_index.Backend()->GetIndex().Set("abcd", "1");
+  temporary_index.Backend()->GetIndex().Flush();
+  BOOST_CHECK_EQUAL("abcd=1;", fuzzy(&index, "abcd"));
+  BOOST_CHECK_EQUAL("abcd=1;", fuzzy(&index, "abcd"));
+
+  temporary_index.Backend()->GetIndex().Set("abcd", "2");
+  temporary_index.Backend()->GetIndex().Flush();
+  BOOST_CHECK_EQUAL("abcd=2;", fuzzy(&index, "abcd"));
+
+  temporary_index.Backend()->GetIndex().Delete("abcd");
+  temporary_index.Backend()->GetIndex().Flush();
+  BOOST_CHECK_EQUAL("", fuzzy(&index, "abcd"));
+  BOOST_CHECK_EQUAL("", fuzzy(&index, "abcd"));
+}
+
+BOOST_AUTO_TEST_CASE(new_generation_new_result) { new_generation_test(0); }
+
+BOOST_AUTO_TEST_CASE(new_generation_new_result_cached) { new_generation_test(1024 * 1024); }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace service
+}  // namespace keyvi_server
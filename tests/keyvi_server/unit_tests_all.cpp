@@ -0,0 +1,28 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * unit_tests_all.cpp
+ *
+ *  Created on: Jun 9, 2021
+ *      Author: hendrik
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE KeyviServer Unit Test Suite
+
+#include <boost/test/unit_test.hpp>
@@ -0,0 +1,100 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * result_cache_test.cpp
+ *
+ *  Created on: Jun 16, 2021
+ *      Author: hendrik
+ */
+
+#include <memory>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi_server/util/result_cache.h"
+
+namespace keyvi_server {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(ResultCacheTests)
+
+ResultCache::value_t value(const std::string& v) { return std::make_shared<std::string>(v); }
+
+BOOST_AUTO_TEST_CASE(get_and_put) {
+  ResultCache cache(1024 * 1024, "test_result_cache_get_and_put");
+
+  BOOST_CHECK(!cache.Get("a", 1));
+  cache.Put("a", 1, value("result a"));
+  cache.Put("b", 1, value("result b"));
+
+  BOOST_CHECK_EQUAL("result a", *cache.Get("a", 1));
+  BOOST_CHECK_EQUAL("result b", *cache.Get("b", 1));
+  BOOST_CHECK_EQUAL(2, cache.Entries());
+  BOOST_CHECK_GT(cache.Bytes(), 0);
+
+  // overwrite
+  cache.Put("a", 1, value("result a2"));
+  BOOST_CHECK_EQUAL("result a2", *cache.Get("a", 1));
+  BOOST_CHECK_EQUAL(2, cache.Entries());
+}
+
+BOOST_AUTO_TEST_CASE(generation) {
+  ResultCache cache(1024 * 1024, "test_result_cache_generation");
+
+  cache.Put("a", 1, value("result a"));
+  BOOST_CHECK_EQUAL("result a", *cache.Get("a", 1));
+
+  // a newer generation invalidates
+  BOOST_CHECK(!cache.Get("a", 2));
+  BOOST_CHECK(!cache.Get("a", 1));
+
+  // results for an older generation are not stored
+  cache.Put("a", 1, value("old result a"));
+  BOOST_CHECK(!cache.Get("a", 2));
+
+  cache.Put("a", 2, value("result a"));
+  BOOST_CHECK_EQUAL("result a", *cache.Get("a", 2));
+}
+
+BOOST_AUTO_TEST_CASE(eviction) {
+  // 16 shards with 1000 bytes each
+  ResultCache cache(16 * 1000, "test_result_cache_eviction");
+  const std::string result(200, 'x');
+
+  for (int i = 0; i < 1000; ++i) {
+    cache.Put("key" + std::to_string(i), 1, value(result));
+    // keep key0 hot
+    BOOST_CHECK(cache.Get("key0", 1));
+  }
+
+  BOOST_CHECK_LE(cache.Bytes(), 16 * 1000);
+  BOOST_CHECK_LT(cache.Entries(), 1000);
+  BOOST_CHECK(cache.Get("key0", 1));
+  BOOST_CHECK(cache.Get("key999", 1));
+  BOOST_CHECK(!cache.Get("key1", 1));
+
+  // too big for a shard
+  cache.Put("big", 1, value(std::string(2000, 'x')));
+  BOOST_CHECK(!cache.Get("big", 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace util
+}  // namespace keyvi_server
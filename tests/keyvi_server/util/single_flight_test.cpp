@@ -0,0 +1,162 @@
+/* keyviserver - A key value store server based on keyvi.
+ *
+ * Copyright 2021 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * single_flight_test.cpp
+ *
+ *  Created on: Jun 9, 2021
+ *      Author: hendrik
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  //NOLINT
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>  //NOLINT
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi_server/util/single_flight.h"
+
+namespace keyvi_server {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(SingleFlightTests)
+
+// run the same call from several threads, the first execution blocks until all threads are started
+void run_concurrently(SingleFlight* single_flight, const std::vector<std::string>& keys, const bool leader_throws,
+                      std::atomic_size_t* executions, std::atomic_size_t* serializations,
+                      std::vector<std::string>* results) {
+  std::atomic_size_t started(0);
+  std::vector<std::thread> threads;
+  results->resize(keys.size());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      std::string value;
+      auto execute = [&]() {
+        const size_t execution = (*executions)++;
+        if (execution == 0) {
+          while (started < keys.size()) {
+            std::this_thread::yield();
+          }
+          // give the other threads time to join the flight
+          std::this_thread::sleep_for(std::chrono::milliseconds(200));
+          if (leader_throws) {
+            throw std::runtime_error("leader failed");
+          }
+        }
+        value = "value for " + keys[i];
+      };
+      auto serialize = [&]() {
+        ++(*serializations);
+        return SingleFlight::result_t(std::make_shared<std::string>(value));
+      };
+
+      ++started;
+      SingleFlight::result_t result;
+      try {
+        if (!single_flight->Do(keys[i], execute, serialize, &result)) {
+          if (result) {
+            value = *result;
+          } else {
+            execute();
+          }
+        }
+      } catch (std::runtime_error&) {
+        value = "exception";
+      }
+      (*results)[i] = value;
+    });
+  }
+
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(identical_calls_share_one_execution) {
+  SingleFlight single_flight;
+  std::atomic_size_t executions(0);
+  std::atomic_size_t serializations(0);
+  std::vector<std::string> results;
+
+  run_concurrently(&single_flight, std::vector<std::string>(8, "key"), false, &executions, &serializations, &results);
+
+  BOOST_CHECK_EQUAL(1, executions);
+  BOOST_CHECK_EQUAL(1, serializations);
+  for (const std::string& result : results) {
+    BOOST_CHECK_EQUAL("value for key", result);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(no_serialization_without_waiters) {
+  SingleFlight single_flight;
+  size_t executions = 0;
+  size_t serializations = 0;
+  SingleFlight::result_t result;
+
+  for (int i = 0; i < 3; ++i) {
+    BOOST_CHECK(single_flight.Do(
+        "key", [&executions]() { ++executions; },
+        [&serializations]() {
+          ++serializations;
+          return SingleFlight::result_t();
+        },
+        &result));
+  }
+
+  BOOST_CHECK_EQUAL(3, executions);
+  BOOST_CHECK_EQUAL(0, serializations);
+}
+
+BOOST_AUTO_TEST_CASE(different_keys_do_not_share) {
+  SingleFlight single_flight;
+  std::atomic_size_t executions(0);
+  std::atomic_size_t serializations(0);
+  std::vector<std::string> results;
+
+  // e.g. the same query against a new generation of the index
+  run_concurrently(&single_flight, {"f1:query", "f2:query"}, false, &executions, &serializations, &results);
+
+  BOOST_CHECK_EQUAL(2, executions);
+  BOOST_CHECK_EQUAL(0, serializations);
+  BOOST_CHECK_EQUAL("value for f1:query", results[0]);
+  BOOST_CHECK_EQUAL("value for f2:query", results[1]);
+}
+
+BOOST_AUTO_TEST_CASE(waiters_execute_if_leader_throws) {
+  SingleFlight single_flight;
+  std::atomic_size_t executions(0);
+  std::atomic_size_t serializations(0);
+  std::vector<std::string> results;
+
+  run_concurrently(&single_flight, std::vector<std::string>(4, "key"), true, &executions, &serializations, &results);
+
+  BOOST_CHECK_EQUAL(4, executions);
+  BOOST_CHECK_EQUAL(0, serializations);
+  BOOST_CHECK_EQUAL(1, std::count(results.begin(), results.end(), "exception"));
+  BOOST_CHECK_EQUAL(3, std::count(results.begin(), results.end(), "value for key"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace util
+}  // namespace keyvi_server